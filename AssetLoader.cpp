@@ -0,0 +1,211 @@
+#include "AssetLoader.hpp"
+
+#include "GLState.hpp"
+#include "MappedFile.hpp"
+#include "Profiler.hpp"
+#include "file_extension.hpp"
+#include "gl_errors.hpp"
+#include "load_baked_texture.hpp"
+#include "load_save_qoi.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
+AssetLoader asset_loader;
+
+AssetLoader::~AssetLoader() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	jobs_changed.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+std::shared_ptr< AssetLoader::Texture const > AssetLoader::load_texture(std::string const &filename, OriginLocation origin) {
+	auto found = textures.find(filename);
+	if (found != textures.end()) return found->second;
+
+	//start workers on first use (rather than when the global is constructed):
+	if (workers.empty()) {
+		if (worker_count == 0) {
+			//leave a core for the game:
+			uint32_t cores = std::thread::hardware_concurrency();
+			worker_count = std::max(1U, std::min(8U, (cores > 1 ? cores - 1 : 1)));
+		}
+		for (uint32_t i = 0; i < worker_count; ++i) {
+			workers.emplace_back(&AssetLoader::decode_jobs, this);
+		}
+	}
+
+	auto texture = std::make_shared< Texture >();
+	texture->filename = filename;
+	textures.emplace(filename, texture);
+	pending += 1;
+
+	Job job;
+	job.texture = texture;
+	job.filename = filename;
+	job.origin = origin;
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		jobs.emplace_back(std::move(job));
+	}
+	jobs_changed.notify_one();
+
+	return texture;
+}
+
+uint32_t AssetLoader::update(float budget_ms) {
+	if (pending == 0) return 0;
+	PROFILE_ZONE("AssetLoader::update");
+
+	auto start = std::chrono::high_resolution_clock::now();
+	uint32_t count = 0;
+	while (true) {
+		Job job;
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			if (decoded.empty()) break;
+			job = std::move(decoded.front());
+			decoded.pop_front();
+		}
+		upload(job);
+		count += 1;
+
+		if (std::chrono::high_resolution_clock::now() - start >= std::chrono::duration< float, std::milli >(budget_ms)) break;
+	}
+	return count;
+}
+
+void AssetLoader::finish() {
+	while (pending) {
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			decoded_changed.wait(lock, [this](){ return !decoded.empty(); });
+		}
+		update(1000.0f);
+	}
+}
+
+void AssetLoader::upload(Job &job) {
+	Texture &texture = *job.texture;
+	assert(texture.status == Texture::Loading);
+	assert(pending > 0);
+	pending -= 1;
+
+	if (!job.error.empty()) {
+		texture.status = Texture::Failed;
+		texture.error = job.error;
+		std::cerr << "WARNING: failed to load texture: " << job.error << std::endl;
+	} else {
+		PROFILE_ZONE("upload texture");
+		if (job.mapped) {
+			//baked: levels go straight from the mapped file to OpenGL:
+			texture.tex = upload_baked_texture(job.baked, &texture.internal_format);
+			texture.levels = uint32_t(job.baked.levels.size());
+			job.mapped.reset();
+		} else {
+			glGenTextures(1, &texture.tex);
+			gl_state.bind_texture(GL_TEXTURE_2D, texture.tex);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, job.size.x, job.size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, job.pixels.data());
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glGenerateMipmap(GL_TEXTURE_2D);
+			GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+			texture.internal_format = GL_RGBA8;
+			texture.levels = 1;
+			for (uint32_t s = std::max(job.size.x, job.size.y); s > 1; s /= 2) texture.levels += 1;
+		}
+		gl_label(GL_TEXTURE, texture.tex, texture.filename.c_str());
+
+		texture.size = job.size;
+		texture.status = Texture::Ready;
+	}
+
+	//keep a few allocations around for the next decodes:
+	std::unique_lock< std::mutex > lock(mutex);
+	if (spare_pixels.size() < 4 && job.pixels.capacity()) spare_pixels.emplace_back(std::move(job.pixels));
+}
+
+void AssetLoader::release() {
+	{ //stop the workers (dropping any queued jobs):
+		std::unique_lock< std::mutex > lock(mutex);
+		jobs.clear();
+		quit = true;
+	}
+	jobs_changed.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	decoded.clear();
+	spare_pixels.clear();
+	quit = false;
+
+	for (auto &name_texture : textures) {
+		Texture &texture = *name_texture.second;
+		if (texture.tex) {
+			glDeleteTextures(1, &texture.tex);
+			gl_state.deleted_texture(texture.tex);
+			texture.tex = 0;
+		}
+		if (texture.status == Texture::Loading) {
+			texture.status = Texture::Failed;
+			texture.error = "Released before loading finished.";
+		}
+	}
+	textures.clear();
+	pending = 0;
+}
+
+void AssetLoader::decode_jobs() {
+	profile_thread_name("asset loader");
+
+	std::unique_lock< std::mutex > lock(mutex);
+	while (true) {
+		jobs_changed.wait(lock, [this](){ return quit || !jobs.empty(); });
+		if (quit) break;
+
+		Job job = std::move(jobs.front());
+		jobs.pop_front();
+		if (!spare_pixels.empty()) {
+			job.pixels = std::move(spare_pixels.back());
+			spare_pixels.pop_back();
+		}
+		lock.unlock();
+
+		try {
+			if (has_extension(job.filename, ".tex")) {
+				PROFILE_ZONE("map baked texture");
+				job.mapped = std::make_shared< MappedFile >(job.filename);
+				parse_baked_texture(job.mapped->data, job.mapped->size, &job.baked);
+				job.size = job.baked.size;
+				//touch every page, so the upload on the main thread doesn't wait on the disk:
+				volatile uint8_t sum = 0;
+				for (size_t i = 0; i < job.mapped->size; i += 4096) sum += job.mapped->data[i];
+			} else {
+				PROFILE_ZONE("decode image");
+				MappedFile file(job.filename);
+				bool qoi = has_extension(job.filename, ".qoi");
+				glm::uvec2 size = (qoi ? qoi_size(file.data, file.size) : png_size(file.data, file.size));
+				job.pixels.resize(size_t(size.x) * size.y);
+				if (qoi) load_qoi(file.data, file.size, &job.size, job.pixels.data(), job.pixels.size(), job.origin);
+				else load_png(file.data, file.size, &job.size, job.pixels.data(), job.pixels.size(), job.origin);
+			}
+		} catch (std::exception &e) {
+			job.mapped.reset();
+			job.error = "'" + job.filename + "': " + e.what();
+		}
+
+		lock.lock();
+		decoded.emplace_back(std::move(job));
+		decoded_changed.notify_all();
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "GL.hpp"
+#include "load_save_png.hpp"
+#include "bake_texture.hpp"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct MappedFile;
+
+/*
+ * AssetLoader loads PNG (or QOI, for files ending in ".qoi") textures in the background.
+ * Baked textures (".tex", see bake_texture.hpp) are just mapped and checked in the
+ *  background, then uploaded straight from the mapping with their own mipmaps.
+ *
+ * Files are read and decoded (see load_png, load_qoi) by a pool of worker threads;
+ *  decoded images wait in a queue until the main (OpenGL) thread uploads them
+ *  in update(), which stops once it has used up its per-frame time budget.
+ *  So startup doesn't scale with the number of textures, and loading during
+ *  play doesn't cause hitches.
+ *
+ * load_texture() returns a handle right away; poll its 'status' to see when
+ *  the texture is ready to draw with (or failed to load).
+ *
+ * Usage:
+ *   auto sprite = asset_loader.load_texture("sprite.png");
+ *   ...each frame, on the main thread:
+ *   asset_loader.update(); //uploads for at most 'budget_ms'
+ *   if (sprite->status == AssetLoader::Texture::Ready) { ...draw with sprite->tex... }
+ *   ...before destroying the OpenGL context:
+ *   asset_loader.release();
+ */
+
+struct AssetLoader {
+	AssetLoader() = default;
+	~AssetLoader(); //(stops the workers, but leaves OpenGL objects to release())
+
+	AssetLoader(AssetLoader const &) = delete;
+	AssetLoader &operator=(AssetLoader const &) = delete;
+
+	//handle to a texture being loaded; only read (or written) from the main thread:
+	struct Texture {
+		std::string filename;
+		enum Status {
+			Loading,
+			Ready, //'tex' and 'size' are set
+			Failed, //'error' says why
+		} status = Loading;
+		GLuint tex = 0; //GL_TEXTURE_2D (see internal_format and levels)
+		glm::uvec2 size = glm::uvec2(0);
+		//images are uploaded as RGBA8 with a full mipmap chain; baked (.tex) textures are uploaded as stored
+		// -- RGBA8 or BC1/BC3 (or RGBA8, if the driver can't take BC1/BC3), with whatever levels were baked:
+		GLenum internal_format = 0; //GL_RGBA8, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+		uint32_t levels = 0; //mipmap levels (1 for textures baked with --no-mips)
+		std::string error;
+	};
+
+	//start loading a texture (loading the same file again returns the same handle):
+	// ('origin' doesn't apply to baked textures, which are always stored bottom-to-top)
+	std::shared_ptr< Texture const > load_texture(std::string const &filename, OriginLocation origin = LowerLeftOrigin);
+
+	//upload decoded textures until 'budget_ms' has passed (always uploads at least one, if any are waiting);
+	// returns the number uploaded (or failed):
+	uint32_t update(float budget_ms = 2.0f);
+
+	//block until every requested texture is ready or failed (e.g., behind a loading screen):
+	void finish();
+
+	//textures that are still Loading:
+	uint32_t pending = 0;
+
+	//delete all textures and stop the workers (call before the OpenGL context is destroyed):
+	void release();
+
+	//number of worker threads (0 = pick based on the number of cores), used when the first load starts them:
+	uint32_t worker_count = 0;
+
+	//----- internals -----
+
+	std::unordered_map< std::string, std::shared_ptr< Texture > > textures;
+
+	struct Job {
+		std::shared_ptr< Texture > texture; //(workers don't touch this, just pass it along)
+		std::string filename;
+		OriginLocation origin;
+		glm::uvec2 size = glm::uvec2(0);
+		std::vector< glm::u8vec4 > pixels;
+		std::string error; //(if decoding failed)
+		std::shared_ptr< MappedFile > mapped; //(for baked textures: the file 'baked' points into)
+		BakedTexture baked;
+	};
+
+	std::mutex mutex;
+	std::condition_variable jobs_changed; //signalled when 'jobs' gets a job (or on quit)
+	std::condition_variable decoded_changed; //signalled when 'decoded' gets a job
+	std::deque< Job > jobs; //waiting to be decoded
+	std::deque< Job > decoded; //waiting to be uploaded
+	std::vector< std::vector< glm::u8vec4 > > spare_pixels; //recycled Job::pixels allocations
+	bool quit = false;
+	std::vector< std::thread > workers;
+
+	void upload(Job &job); //(main thread)
+	void decode_jobs(); //worker thread body
+};
+
+extern AssetLoader asset_loader;
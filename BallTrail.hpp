@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+/*
+ * BallTrail remembers recent ball positions in a fixed-size ring buffer.
+ * Each point is stamped with the (game) time at which it was recorded, so
+ *  nothing needs to be aged as time passes; lookups by time use binary search.
+ * Storage is inline (no allocation), so a BallTrail is cheap to copy.
+ */
+
+struct BallTrail {
+	//NOTE: enough for a 2 second trail at the fixed 120 updates/second (Mode::Tick); past that the oldest points are overwritten early.
+	// (kept small since it is most of the size of a PongState snapshot)
+	static constexpr uint32_t Capacity = 256;
+	static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+	struct Point {
+		glm::vec2 at;
+		double time;
+	};
+
+	//forget all points:
+	void clear() {
+		first = 0;
+		count = 0;
+	}
+
+	//record a point; 'time' must not be less than the newest point's time:
+	void push(glm::vec2 const &at, double time) {
+		if (count == Capacity) {
+			first = (first + 1) & (Capacity - 1);
+			count -= 1;
+		}
+		Point &p = points[(first + count) & (Capacity - 1)];
+		p.at = at;
+		p.time = time;
+		count += 1;
+	}
+
+	//drop points that are no longer needed to look up times >= 'oldest':
+	//NOTE: since lookups interpolate between points, keeps the newest point older than 'oldest'.
+	void trim(double oldest) {
+		while (count >= 2 && (*this)[1].time <= oldest) {
+			first = (first + 1) & (Capacity - 1);
+			count -= 1;
+		}
+	}
+
+	//points in order, oldest first:
+	Point const &operator[](uint32_t i) const {
+		return points[(first + i) & (Capacity - 1)];
+	}
+	uint32_t size() const { return count; }
+
+	//position at 'time', interpolated between the points around it:
+	// returns false if 'time' is older than the oldest point (or the trail is empty).
+	bool lookup(double time, glm::vec2 *at) const {
+		if (count == 0 || time < (*this)[0].time) return false;
+		if (time >= (*this)[count-1].time) {
+			*at = (*this)[count-1].at;
+			return true;
+		}
+		//binary search for the first point newer than 'time':
+		uint32_t lo = 1, hi = count - 1;
+		while (lo < hi) {
+			uint32_t mid = (lo + hi) / 2;
+			if ((*this)[mid].time > time) hi = mid;
+			else lo = mid + 1;
+		}
+		Point const &a = (*this)[lo-1];
+		Point const &b = (*this)[lo];
+		float t = float((time - a.time) / (b.time - a.time));
+		*at = t * (b.at - a.at) + a.at;
+		return true;
+	}
+
+	Point points[Capacity];
+	uint32_t first = 0; //index of oldest point
+	uint32_t count = 0; //number of points stored
+};
@@ -2,6 +2,7 @@
 
 #include "gl_compile_program.hpp"
 #include "gl_errors.hpp"
+#include "GLState.hpp"
 
 ColorTextureProgram::ColorTextureProgram() {
 	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
@@ -33,6 +34,8 @@ ColorTextureProgram::ColorTextureProgram() {
 	//As you can see above, adjacent strings in C/C++ are concatenated.
 	// this is very useful for writing long shader programs inline.
 
+	gl_label(GL_PROGRAM, program, "ColorTextureProgram");
+
 	//look up the locations of vertex attributes:
 	Position_vec4 = glGetAttribLocation(program, "Position");
 	Color_vec4 = glGetAttribLocation(program, "Color");
@@ -43,14 +46,15 @@ ColorTextureProgram::ColorTextureProgram() {
 	GLuint TEX_sampler2D = glGetUniformLocation(program, "TEX");
 
 	//set TEX to always refer to texture binding zero:
-	glUseProgram(program); //bind program -- glUniform* calls refer to this program now
+	gl_state.use_program(program); //bind program -- glUniform* calls refer to this program now
 
 	glUniform1i(TEX_sampler2D, 0); //set TEX to sample from GL_TEXTURE0
 
-	glUseProgram(0); //unbind program -- glUniform* calls refer to ??? now
+	gl_state.use_program(0); //unbind program -- glUniform* calls refer to ??? now
 }
 
 ColorTextureProgram::~ColorTextureProgram() {
 	glDeleteProgram(program);
+	gl_state.deleted_program(program);
 	program = 0;
 }
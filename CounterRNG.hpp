@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * CounterRNG is a counter-based pseudo-random number generator
+ *  (Philox4x32-10; Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC 2011).
+ *
+ * Output number 'counter' is a pure function of (seed, stream, counter), so:
+ *  - the whole state is 40 bytes (24, plus the current block of four outputs)
+ *    and copying it forks the sequence exactly;
+ *  - generators with different streams never overlap, so each match (or thread)
+ *    can get its own stream and results don't depend on how work is scheduled.
+ *
+ * Satisfies UniformRandomBitGenerator, so it can be used like std::mt19937.
+ */
+
+struct CounterRNG {
+	typedef uint32_t result_type;
+
+	CounterRNG(uint64_t seed = 0, uint64_t stream = 0) : seed_(seed), stream_(stream) { }
+
+	uint64_t seed() const { return seed_; } //key
+	uint64_t stream() const { return stream_; } //upper half of the Philox counter
+	uint64_t counter() const { return counter_; } //number of values drawn so far
+
+	//jump (forward or back) so the next value drawn is number 'counter':
+	void seek(uint64_t counter) {
+		counter_ = counter;
+		if (counter_ % 4 != 0) generate(seed_, stream_, counter_ / 4, block_);
+	}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return 0xffffffffu; }
+
+	result_type operator()() {
+		if (counter_ % 4 == 0) generate(seed_, stream_, counter_ / 4, block_);
+		result_type ret = block_[counter_ % 4];
+		counter_ += 1;
+		return ret;
+	}
+
+	//the four 32-bit outputs of Philox4x32-10 for a given key and 128-bit counter (stream, index):
+	static void generate(uint64_t key, uint64_t stream, uint64_t index, uint32_t out[4]) {
+		uint32_t c[4] = { uint32_t(index), uint32_t(index >> 32), uint32_t(stream), uint32_t(stream >> 32) };
+		uint32_t k[2] = { uint32_t(key), uint32_t(key >> 32) };
+		for (uint32_t round = 0; round < 10; ++round) {
+			uint64_t p0 = uint64_t(0xD2511F53u) * c[0];
+			uint64_t p1 = uint64_t(0xCD9E8D57u) * c[2];
+			uint32_t n[4] = {
+				uint32_t(p1 >> 32) ^ c[1] ^ k[0],
+				uint32_t(p1),
+				uint32_t(p0 >> 32) ^ c[3] ^ k[1],
+				uint32_t(p0)
+			};
+			c[0] = n[0]; c[1] = n[1]; c[2] = n[2]; c[3] = n[3];
+			k[0] += 0x9E3779B9u;
+			k[1] += 0xBB67AE85u;
+		}
+		out[0] = c[0]; out[1] = c[1]; out[2] = c[2]; out[3] = c[3];
+	}
+
+private:
+	//(private, since block_ caches outputs for the current seed, stream, and counter; change those with the constructor or seek())
+	uint64_t seed_;
+	uint64_t stream_;
+	uint64_t counter_ = 0;
+	uint32_t block_[4] = { 0, 0, 0, 0 }; //outputs (counter_ & ~3) .. (counter_ | 3), once counter_ % 4 != 0
+	// (each Philox block gives four outputs, so the rounds only run every fourth draw)
+};
@@ -0,0 +1,129 @@
+#include "DrawRects.hpp"
+
+#include "gl_errors.hpp"
+#include "GLState.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cassert>
+#include <cstddef>
+
+DrawRects::DrawRects(GLsizeiptr frame_size) : instance_stream(frame_size) {
+	{ //unit quad:
+		glm::vec2 corners[4] = {
+			glm::vec2(-1.0f,-1.0f), glm::vec2( 1.0f,-1.0f),
+			glm::vec2(-1.0f, 1.0f), glm::vec2( 1.0f, 1.0f),
+		};
+		glGenBuffers(1, &corners_buffer);
+		gl_state.bind_buffer(GL_ARRAY_BUFFER, corners_buffer);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+		gl_label(GL_BUFFER, corners_buffer, "DrawRects corners");
+	}
+
+	{ //vertex array:
+		glGenVertexArrays(1, &vertex_array);
+		gl_state.bind_vertex_array(vertex_array);
+		gl_label(GL_VERTEX_ARRAY, vertex_array, "DrawRects");
+
+		//corners advance per-vertex:
+		gl_state.bind_buffer(GL_ARRAY_BUFFER, corners_buffer);
+		glVertexAttribPointer(program.Corner_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (GLbyte *)0 + 0);
+		glEnableVertexAttribArray(program.Corner_vec2);
+
+		//everything else advances per-instance:
+		// (pointers are set in draw(), since the data moves around instance_stream)
+		glVertexAttribDivisor(program.Center_vec2, 1);
+		glEnableVertexAttribArray(program.Center_vec2);
+		glVertexAttribDivisor(program.Radius_vec2, 1);
+		glEnableVertexAttribArray(program.Radius_vec2);
+		glVertexAttribDivisor(program.Color_vec4, 1);
+		glEnableVertexAttribArray(program.Color_vec4);
+
+	}
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+DrawRects::~DrawRects() {
+	glDeleteVertexArrays(1, &vertex_array);
+	gl_state.deleted_vertex_array(vertex_array);
+	vertex_array = 0;
+
+	glDeleteBuffers(1, &corners_buffer);
+	gl_state.deleted_buffer(corners_buffer);
+	corners_buffer = 0;
+
+	if (static_buffer) {
+		glDeleteBuffers(1, &static_buffer);
+		gl_state.deleted_buffer(static_buffer);
+		static_buffer = 0;
+	}
+}
+
+DrawRects::Rect *DrawRects::map(uint32_t max_count) {
+	rects_count = 0;
+	return reinterpret_cast< Rect * >(instance_stream.map(max_count * sizeof(Rect), sizeof(Rect), &rects_offset));
+}
+
+void DrawRects::unmap(uint32_t count) {
+	instance_stream.unmap();
+	rects_count = count;
+}
+
+void DrawRects::draw(glm::mat4 const &object_to_clip) {
+	draw(object_to_clip, 0, rects_count);
+}
+
+void DrawRects::draw(glm::mat4 const &object_to_clip, uint32_t first, uint32_t count) {
+	assert(first + count <= rects_count);
+	draw_instances(object_to_clip, instance_stream.buffer, rects_offset + GLintptr(first) * sizeof(Rect), count);
+}
+
+void DrawRects::end_frame() {
+	//done drawing from this frame's part of instance_stream:
+	instance_stream.end_frame();
+	rects_count = 0;
+}
+
+void DrawRects::set_static(std::vector< Rect > const &rects) {
+	bool created = false;
+	if (!static_buffer) {
+		glGenBuffers(1, &static_buffer);
+		created = true;
+	}
+
+	gl_state.bind_buffer(GL_ARRAY_BUFFER, static_buffer);
+	if (created) gl_label(GL_BUFFER, static_buffer, "DrawRects static rects");
+	glBufferData(GL_ARRAY_BUFFER, rects.size() * sizeof(Rect), rects.data(), GL_STATIC_DRAW);
+
+	static_count = uint32_t(rects.size());
+	static_uploads += 1;
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+void DrawRects::draw_static(glm::mat4 const &object_to_clip, uint32_t first, uint32_t count) {
+	assert(first + count <= static_count);
+	draw_instances(object_to_clip, static_buffer, GLintptr(first) * sizeof(Rect), count);
+}
+
+void DrawRects::draw_instances(glm::mat4 const &object_to_clip, GLuint buffer, GLintptr offset, uint32_t count) {
+	if (count == 0) return;
+
+	gl_state.use_program(program.program);
+	glUniformMatrix4fv(program.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
+
+	gl_state.bind_vertex_array(vertex_array);
+
+	//point per-instance attributes at the rects:
+	// (there is no base-instance parameter in GL 3.3, so the offset goes here instead)
+	gl_state.bind_buffer(GL_ARRAY_BUFFER, buffer);
+	glVertexAttribPointer(program.Center_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(Rect), (GLbyte *)0 + offset + offsetof(Rect, center));
+	glVertexAttribPointer(program.Radius_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(Rect), (GLbyte *)0 + offset + offsetof(Rect, radius));
+	glVertexAttribPointer(program.Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Rect), (GLbyte *)0 + offset + offsetof(Rect, color));
+
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, GLsizei(count));
+
+
+	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
+}
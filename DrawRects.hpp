@@ -0,0 +1,90 @@
+#pragma once
+
+#include "RectProgram.hpp"
+#include "StreamingBuffer.hpp"
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+/*
+ * DrawRects draws many solid-colored, axis-aligned rectangles with one instanced draw call.
+ * Each rectangle is a 20-byte Rect (center, radius, color) written straight into a
+ *  StreamingBuffer; the shared unit quad lives in a static buffer, so the per-frame
+ *  upload is a seventh of the six 24-byte vertices a rectangle used to take.
+ *
+ * Rectangles that rarely change (e.g., the court walls) can instead be kept in a
+ *  static buffer with set_static(), which is only re-uploaded when called again.
+ *
+ * Usage, each frame:
+ *   DrawRects::Rect *rects = draw_rects.map(max_count);
+ *   ... write up to 'max_count' rects (e.g., with placement new) ...
+ *   draw_rects.unmap(count);
+ *   ... set up blending, etc ...
+ *   draw_rects.draw(object_to_clip); //and/or draw_static(), in any order
+ *   draw_rects.end_frame();
+ */
+
+#include <vector>
+
+struct DrawRects {
+	struct Rect {
+		Rect(glm::vec2 const &center_, glm::vec2 const &radius_, glm::u8vec4 const &color_) :
+			center(center_), radius(radius_), color(color_) { }
+		glm::vec2 center;
+		glm::vec2 radius;
+		glm::u8vec4 color;
+	};
+	static_assert(sizeof(Rect) == 4*2 + 4*2 + 1*4, "DrawRects::Rect should be packed");
+
+	//'frame_size' is the starting size (in bytes) of each frame's region of the instance stream:
+	DrawRects(GLsizeiptr frame_size = 1 << 14);
+	~DrawRects();
+
+	DrawRects(DrawRects const &) = delete;
+	DrawRects &operator=(DrawRects const &) = delete;
+
+	//reserve room for this frame's rectangles (call once per frame, then unmap()):
+	Rect *map(uint32_t max_count);
+	//finish writing rectangles; 'count' is how many of the reserved ones were written:
+	void unmap(uint32_t count);
+
+	//draw this frame's rectangles (in the order written), transformed by 'object_to_clip':
+	// (uses the current blend state; binds program and vertex array through gl_state)
+	void draw(glm::mat4 const &object_to_clip);
+	//...or just rectangles [first, first+count) of them:
+	void draw(glm::mat4 const &object_to_clip, uint32_t first, uint32_t count);
+
+	//call after the frame's draws have been issued:
+	void end_frame();
+
+	//----- static rectangles -----
+
+	//replace the static rectangles (uploaded once, to a GL_STATIC_DRAW buffer):
+	void set_static(std::vector< Rect > const &rects);
+	//draw static rectangles [first, first+count):
+	void draw_static(glm::mat4 const &object_to_clip, uint32_t first, uint32_t count);
+
+	uint32_t static_count = 0; //number of static rectangles
+	uint32_t static_uploads = 0; //number of times set_static() has been called
+
+	//----- internals -----
+
+	RectProgram program;
+
+	//unit quad, as a four-vertex triangle strip:
+	GLuint corners_buffer = 0;
+
+	//per-instance Rects:
+	StreamingBuffer instance_stream;
+
+	//maps corners_buffer + instance_stream.buffer to program's attributes:
+	GLuint vertex_array = 0;
+
+	GLintptr rects_offset = 0; //this frame's rects, as an offset into instance_stream.buffer
+	uint32_t rects_count = 0;
+
+	GLuint static_buffer = 0;
+
+	//draw 'count' rects starting at 'offset' bytes into 'buffer':
+	void draw_instances(glm::mat4 const &object_to_clip, GLuint buffer, GLintptr offset, uint32_t count);
+};
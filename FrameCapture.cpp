@@ -0,0 +1,301 @@
+#include "FrameCapture.hpp"
+
+#include "GLState.hpp"
+#include "Profiler.hpp"
+#include "file_extension.hpp"
+#include "gl_errors.hpp"
+#include "load_save_png.hpp"
+#include "load_save_qoi.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+FrameCapture::FrameCapture(uint32_t writer_count) {
+	if (writer_count == 0) {
+		//leave a core for the game and one for the driver:
+		uint32_t cores = std::thread::hardware_concurrency();
+		writer_count = std::max(1U, std::min(8U, (cores > 2 ? cores - 2 : 1)));
+	}
+	for (uint32_t i = 0; i < writer_count; ++i) {
+		writers.emplace_back(&FrameCapture::write_jobs, this);
+	}
+}
+
+FrameCapture::~FrameCapture() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	jobs_changed.notify_all();
+	for (auto &writer : writers) {
+		writer.join();
+	}
+}
+
+void FrameCapture::request(std::string const &filename) {
+	requested = filename;
+}
+
+void FrameCapture::start_recording(std::string const &prefix) {
+	if (recording) stop_recording();
+	recording = true;
+	record_prefix = prefix;
+	record_frame = 0;
+	record_written = 0;
+	record_dropped = 0;
+	std::cout << "Recording frames to '" << record_prefix << "-NNNNNN" << record_extension << "'." << std::endl;
+}
+
+void FrameCapture::stop_recording() {
+	if (!recording) return;
+	recording = false;
+	//read back the frames still in flight (oldest first), so they make it into the report below:
+	for (uint32_t i = 0; i < Slots; ++i) {
+		Slot &slot = slots[(next_slot + i) % Slots];
+		if (slot.fence && slot.recorded) collect(slot, true);
+	}
+	std::cout << "Recorded " << record_frame << " frames to '" << record_prefix << "-NNNNNN" << record_extension << "': "
+		<< record_written << " saved, " << record_dropped << " dropped." << std::endl;
+}
+
+void FrameCapture::end_frame(glm::uvec2 const &drawable_size) {
+	PROFILE_ZONE("FrameCapture::end_frame");
+
+	//unmap slots the writers are done with, and hand off any readbacks that are done:
+	reclaim();
+	for (auto &slot : slots) {
+		if (slot.fence) collect(slot, false);
+	}
+
+	//figure out what (if anything) to save this frame as:
+	std::vector< std::string > filenames;
+	if (!requested.empty()) {
+		filenames.emplace_back(requested);
+	}
+	if (recording) {
+		char number[16];
+		std::snprintf(number, sizeof(number), "-%06u", record_frame);
+		filenames.emplace_back(record_prefix + number + record_extension);
+		record_frame += 1;
+	}
+	if (filenames.empty()) return;
+
+	//drop the frame if capture is falling behind:
+	GLsizeiptr size = GLsizeiptr(drawable_size.x) * drawable_size.y * 4;
+	Slot &slot = slots[next_slot];
+	bool busy = (slot.fence || slot.mapped);
+	bool over_budget;
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		over_budget = (pending_bytes + size_t(size) > budget);
+		if (!busy && !over_budget) pending_bytes += size_t(size);
+	}
+	if (busy || over_budget) {
+		char const *reason = (busy ? "readbacks in flight" : "over memory budget");
+		if (recording) {
+			if (busy) dropped_busy += 1;
+			else dropped_budget += 1;
+			record_dropped += 1;
+			if (record_dropped == 1) {
+				std::cerr << "NOTE: capture is falling behind (" << reason << "); dropping frames." << std::endl;
+			}
+		}
+		//(screenshots aren't dropped; 'requested' stays set, so the next frame tries again)
+		if (!requested.empty() && !requested_delayed) {
+			std::cerr << "NOTE: capture is busy (" << reason << "); screenshot '" << requested << "' will be taken from a later frame." << std::endl;
+			requested_delayed = true;
+		}
+		return;
+	}
+	next_slot = (next_slot + 1) % Slots;
+	requested.clear();
+	requested_delayed = false;
+
+	if (!slot.buffer) {
+		glGenBuffers(1, &slot.buffer);
+	}
+	gl_state.bind_buffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	if (slot.buffer_size != size) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		slot.buffer_size = size;
+		gl_label(GL_BUFFER, slot.buffer, "FrameCapture");
+	}
+
+	//start copying the back buffer into the pixel pack buffer (returns right away):
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glReadBuffer(GL_BACK);
+	glReadPixels(0, 0, drawable_size.x, drawable_size.y, GL_RGBA, GL_UNSIGNED_BYTE, (GLbyte *)0 + 0);
+	gl_state.bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.size = drawable_size;
+	slot.filenames = std::move(filenames);
+	slot.recorded = recording;
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+bool FrameCapture::collect(Slot &slot, bool wait) {
+	assert(slot.fence);
+	assert(!slot.mapped);
+
+	GLenum result = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000ull : 0);
+	if (result == GL_TIMEOUT_EXPIRED) return false;
+	glDeleteSync(slot.fence);
+	slot.fence = 0;
+
+	size_t bytes = size_t(slot.size.x) * slot.size.y * sizeof(glm::u8vec4);
+
+	//map the buffer for the writers to copy out of:
+	// (only the map and unmap calls need the OpenGL thread -- the pointer itself works from any thread)
+	void const *data = nullptr;
+	if (result != GL_WAIT_FAILED) {
+		gl_state.bind_buffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.buffer_size, GL_MAP_READ_BIT);
+		gl_state.bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+	if (!data) {
+		std::cerr << "WARNING: failed to read back capture of '" << slot.filenames[0] << "'; skipping it." << std::endl;
+		slot.filenames.clear();
+		std::unique_lock< std::mutex > lock(mutex);
+		pending_bytes -= bytes;
+		return false;
+	}
+	slot.mapped = reinterpret_cast< glm::u8vec4 const * >(data);
+	slot.copied = false;
+
+	Job job;
+	job.filenames = std::move(slot.filenames);
+	job.size = slot.size;
+	job.slot = uint32_t(&slot - slots);
+	job.mapped = slot.mapped;
+	if (slot.recorded) {
+		//keep up with the frame rate:
+		job.level = 1;
+		job.threads = 1;
+	} else {
+		//screenshots are rare, so make them smaller (and spread the extra work over every core):
+		job.level = 6;
+		job.threads = 0;
+	}
+
+	written += 1;
+	if (slot.recorded) record_written += 1;
+
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		jobs.emplace_back(std::move(job));
+	}
+	jobs_changed.notify_one();
+
+	return true;
+}
+
+void FrameCapture::reclaim() {
+	std::unique_lock< std::mutex > lock(mutex);
+	for (auto &slot : slots) {
+		if (slot.mapped && slot.copied) {
+			gl_state.bind_buffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			gl_state.bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+			slot.mapped = nullptr;
+			slot.copied = false;
+		}
+	}
+}
+
+void FrameCapture::finish() {
+	stop_recording();
+
+	//read back whatever is still in flight (oldest first):
+	for (uint32_t i = 0; i < Slots; ++i) {
+		Slot &slot = slots[(next_slot + i) % Slots];
+		if (slot.fence) collect(slot, true);
+	}
+	if (!requested.empty()) {
+		std::cerr << "WARNING: screenshot '" << requested << "' was never taken." << std::endl;
+		requested.clear();
+	}
+
+	{ //wait for the writers to finish up:
+		std::unique_lock< std::mutex > lock(mutex);
+		jobs_changed.wait(lock, [this](){ return jobs.empty() && writing == 0; });
+		spare_pixels.clear();
+	}
+
+	//unmap and free buffers:
+	reclaim();
+	for (auto &slot : slots) {
+		assert(!slot.mapped);
+		if (slot.buffer) {
+			glDeleteBuffers(1, &slot.buffer);
+			gl_state.deleted_buffer(slot.buffer);
+			slot.buffer = 0;
+			slot.buffer_size = 0;
+		}
+	}
+
+	if (dropped_busy || dropped_budget) {
+		std::cout << "Frame capture: " << written << " frames saved; dropped " << dropped_busy << " (readbacks in flight) + " << dropped_budget << " (over memory budget)." << std::endl;
+	}
+}
+
+void FrameCapture::write_jobs() {
+	profile_thread_name("capture writer");
+
+	std::unique_lock< std::mutex > lock(mutex);
+	while (true) {
+		jobs_changed.wait(lock, [this](){ return quit || !jobs.empty(); });
+		if (jobs.empty()) break; //(only quit once the queue is empty)
+
+		Job job = std::move(jobs.front());
+		jobs.pop_front();
+		writing += 1;
+		if (!spare_pixels.empty()) {
+			job.pixels = std::move(spare_pixels.back());
+			spare_pixels.pop_back();
+		}
+		lock.unlock();
+
+		{
+			PROFILE_ZONE("FrameCapture copy");
+			//copy out of the mapped buffer, so the slot can go back to the OpenGL thread before the (slow) encode;
+			// the window may not have an alpha channel, so whatever alpha was read back isn't meaningful:
+			job.pixels.resize(size_t(job.size.x) * job.size.y);
+			for (size_t i = 0; i < job.pixels.size(); ++i) {
+				job.pixels[i] = job.mapped[i];
+				job.pixels[i].a = 0xff;
+			}
+			job.mapped = nullptr;
+		}
+
+		lock.lock();
+		slots[job.slot].copied = true; //(unmapped by the next end_frame() or finish())
+		lock.unlock();
+
+		{
+			PROFILE_ZONE("FrameCapture write");
+			for (auto const &filename : job.filenames) {
+				try {
+					if (has_extension(filename, ".qoi")) {
+						save_qoi(filename, job.size, job.pixels.data(), LowerLeftOrigin);
+					} else {
+						save_png_parallel(filename, job.size, job.pixels.data(), LowerLeftOrigin, job.level, job.threads);
+					}
+				} catch (std::exception &e) {
+					std::cerr << "WARNING: failed to save '" << filename << "': " << e.what() << std::endl;
+				}
+			}
+		}
+
+		lock.lock();
+		writing -= 1;
+		pending_bytes -= job.pixels.size() * sizeof(glm::u8vec4);
+		//keep a few allocations around for the next frames:
+		if (spare_pixels.size() < 4) spare_pixels.emplace_back(std::move(job.pixels));
+		jobs_changed.notify_all();
+	}
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * FrameCapture saves drawn frames to PNG files without stalling the frame loop.
+ *
+ * A captured frame is read back (right after it is drawn) into one of a ring
+ *  of pixel buffer objects, so glReadPixels returns immediately; a fence tells
+ *  when the copy is done, a frame or two later. The buffer is then mapped and
+ *  handed to a pool of writer threads, which copy the pixels out (fixing up
+ *  alpha on the way), give the slot back to be unmapped and reused, and encode +
+ *  save the PNGs (see save_png_parallel) or QOIs. Recorded frames
+ *  use fast compression on one thread each, since the pool already works on
+ *  several frames at once; screenshots use better compression split across
+ *  every core.
+ *
+ * It can save single frames (screenshots) or every frame (recording, as a
+ *  numbered PNG sequence). Pixels waiting to be written are limited to 'budget'
+ *  bytes; recorded frames that would go over budget -- or that find every slot
+ *  busy -- are dropped (and counted) rather than making the game wait, while
+ *  screenshots wait for the next frame that fits.
+ *
+ * Usage:
+ *   capture.request("screenshot.png"); //at any time
+ *   capture.start_recording("capture"); //capture-000000.png, capture-000001.png, ...
+ *   ...each frame, after drawing but before swapping:
+ *   capture.end_frame(drawable_size);
+ *   ...before destroying the OpenGL context:
+ *   capture.finish();
+ */
+
+struct FrameCapture {
+	static constexpr uint32_t Slots = 4; //readbacks that can be in flight at once
+
+	//'writers' is the number of encoder threads (0 = pick based on the number of cores):
+	FrameCapture(uint32_t writers = 0);
+	~FrameCapture(); //(waits for the writer threads, but leaves OpenGL objects to finish())
+
+	FrameCapture(FrameCapture const &) = delete;
+	FrameCapture &operator=(FrameCapture const &) = delete;
+
+	//save the next frame to 'filename' (as QOI if it ends in ".qoi", otherwise as PNG):
+	void request(std::string const &filename);
+
+	//save every frame to 'prefix'-NNNNNN.png (or .qoi, see record_extension) until stop_recording():
+	// (frame numbers count dropped frames too, so drops show up as gaps)
+	void start_recording(std::string const &prefix);
+	void stop_recording(); //(prints a summary)
+	bool recording = false;
+	std::string record_extension = ".png"; //".qoi" is much faster to encode (but larger, and fewer tools read it)
+
+	//read back the just-drawn frame (from GL_BACK) if it is being captured, and pass finished readbacks to the writers:
+	void end_frame(glm::uvec2 const &drawable_size);
+
+	//stop recording, wait for all readbacks and writes, then free OpenGL resources:
+	void finish();
+
+	//most bytes of pixels allowed to be waiting for (or in) readback or writing:
+	size_t budget = size_t(512) << 20;
+
+	//statistics:
+	uint32_t written = 0; //frames read back and handed to writers
+	uint32_t dropped_busy = 0; //frames skipped because every slot was still being read back
+	uint32_t dropped_budget = 0; //frames skipped because writers were too far behind
+
+	//----- internals -----
+
+	std::string requested; //filename of requested screenshot (if not empty; cleared once its readback starts)
+	bool requested_delayed = false; //(so a waiting screenshot is only reported once)
+
+	std::string record_prefix;
+	uint32_t record_frame = 0; //number of next recorded frame
+	uint32_t record_written = 0, record_dropped = 0; //(for stop_recording()'s summary)
+
+	struct Slot {
+		GLuint buffer = 0; //pixel pack buffer
+		GLsizeiptr buffer_size = 0;
+		GLsync fence = 0; //set while a readback is in flight
+		glm::u8vec4 const *mapped = nullptr; //set while a writer is copying out of the buffer
+		bool copied = false; //set (under 'mutex') by the writer when it is done with 'mapped'
+		glm::uvec2 size = glm::uvec2(0);
+		std::vector< std::string > filenames; //files to save the frame as
+		bool recorded = false; //part of a recording (vs. only a screenshot)
+	};
+	Slot slots[Slots];
+	uint32_t next_slot = 0;
+
+	//map a finished slot's buffer and queue it for writing (waits for the readback if 'wait'):
+	bool collect(Slot &slot, bool wait);
+
+	//unmap the slots the writers are done copying from:
+	void reclaim();
+
+	//writer threads and their queue:
+	struct Job {
+		std::vector< std::string > filenames;
+		glm::uvec2 size;
+		uint32_t slot; //slot whose mapped buffer holds the pixels
+		glm::u8vec4 const *mapped;
+		std::vector< glm::u8vec4 > pixels; //(filled in by the writer)
+		int level; //zlib compression level
+		uint32_t threads; //encoder threads (0 = one per core)
+	};
+	std::mutex mutex;
+	std::condition_variable jobs_changed;
+	std::deque< Job > jobs;
+	uint32_t writing = 0; //jobs currently being written
+	size_t pending_bytes = 0; //pixels in readback, queued, or being written
+	std::vector< std::vector< glm::u8vec4 > > spare_pixels; //recycled Job::pixels allocations
+	bool quit = false;
+	std::vector< std::thread > writers;
+
+	void write_jobs(); //writer thread body
+};
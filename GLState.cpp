@@ -0,0 +1,114 @@
+#include "GLState.hpp"
+
+#include <cassert>
+
+GLState gl_state;
+
+bool GLState::change(GLuint *cached, GLuint value) {
+	if (*cached == value) {
+		avoided += 1;
+		return false;
+	}
+	*cached = value;
+	calls += 1;
+	return true;
+}
+
+void GLState::use_program(GLuint program_) {
+	if (change(&program, program_)) glUseProgram(program_);
+}
+
+void GLState::bind_vertex_array(GLuint vertex_array_) {
+	if (change(&vertex_array, vertex_array_)) glBindVertexArray(vertex_array_);
+}
+
+void GLState::bind_buffer(GLenum target, GLuint buffer) {
+	GLuint *cached = nullptr;
+	if (target == GL_ARRAY_BUFFER) cached = &array_buffer;
+	else if (target == GL_PIXEL_PACK_BUFFER) cached = &pixel_pack_buffer;
+	else if (target == GL_PIXEL_UNPACK_BUFFER) cached = &pixel_unpack_buffer;
+
+	if (!cached || change(cached, buffer)) glBindBuffer(target, buffer);
+}
+
+void GLState::active_texture(GLenum unit) {
+	assert(unit >= GL_TEXTURE0 && unit < GL_TEXTURE0 + TextureUnits);
+	if (change(&texture_unit, unit - GL_TEXTURE0)) glActiveTexture(unit);
+}
+
+void GLState::bind_texture(GLenum target, GLuint texture) {
+	if (target != GL_TEXTURE_2D) {
+		glBindTexture(target, texture);
+		return;
+	}
+	if (texture_unit == Unknown) {
+		//don't know which unit this affects, so forget all of them:
+		for (auto &t : texture_2d) t = Unknown;
+		calls += 1;
+		glBindTexture(target, texture);
+		return;
+	}
+	if (change(&texture_2d[texture_unit], texture)) glBindTexture(target, texture);
+}
+
+void GLState::enable(GLenum cap) {
+	GLuint *cached = nullptr;
+	if (cap == GL_BLEND) cached = &blend;
+	else if (cap == GL_DEPTH_TEST) cached = &depth_test;
+
+	if (!cached || change(cached, GL_TRUE)) glEnable(cap);
+}
+
+void GLState::disable(GLenum cap) {
+	GLuint *cached = nullptr;
+	if (cap == GL_BLEND) cached = &blend;
+	else if (cap == GL_DEPTH_TEST) cached = &depth_test;
+
+	if (!cached || change(cached, GL_FALSE)) glDisable(cap);
+}
+
+void GLState::blend_func(GLenum sfactor, GLenum dfactor) {
+	if (blend_sfactor == sfactor && blend_dfactor == dfactor) {
+		avoided += 1;
+		return;
+	}
+	blend_sfactor = sfactor;
+	blend_dfactor = dfactor;
+	calls += 1;
+	glBlendFunc(sfactor, dfactor);
+}
+
+void GLState::deleted_program(GLuint program_) {
+	//(a deleted program stays in use until another one is, but after that its name may be reused)
+	if (program == program_) program = Unknown;
+}
+
+void GLState::deleted_vertex_array(GLuint vertex_array_) {
+	if (vertex_array == vertex_array_) vertex_array = 0;
+}
+
+void GLState::deleted_buffer(GLuint buffer) {
+	if (array_buffer == buffer) array_buffer = 0;
+	if (pixel_pack_buffer == buffer) pixel_pack_buffer = 0;
+	if (pixel_unpack_buffer == buffer) pixel_unpack_buffer = 0;
+}
+
+void GLState::deleted_texture(GLuint texture) {
+	for (auto &t : texture_2d) {
+		if (t == texture) t = 0;
+	}
+}
+
+void GLState::invalidate() {
+	program = Unknown;
+	vertex_array = Unknown;
+	array_buffer = Unknown;
+	pixel_pack_buffer = Unknown;
+	pixel_unpack_buffer = Unknown;
+	texture_unit = Unknown;
+	for (auto &t : texture_2d) t = Unknown;
+	blend = Unknown;
+	depth_test = Unknown;
+	blend_sfactor = Unknown;
+	blend_dfactor = Unknown;
+}
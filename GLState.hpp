@@ -0,0 +1,73 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <stdint.h>
+
+/*
+ * GLState shadows the OpenGL state that drawing code changes most often --
+ *  program, vertex array, buffer and texture bindings, blending, and depth
+ *  testing -- and skips calls that would set something that is already set.
+ *
+ * So code can just set what it needs before each draw, without unbinding
+ *  afterward, and only actual changes reach the driver.
+ *
+ * For this to work, *all* changes to the tracked state must go through gl_state:
+ *  - bind/use with gl_state.use_program(), .bind_vertex_array(), .bind_buffer(), etc.
+ *  - after deleting an object, call the matching gl_state.deleted_*() so a
+ *    recycled name isn't mistaken for a binding that is already in place.
+ *  - if other code (e.g., a library) may have changed state, call gl_state.invalidate().
+ */
+
+struct GLState {
+	//----- bindings -----
+	void use_program(GLuint program);
+	void bind_vertex_array(GLuint vertex_array);
+	//(GL_ARRAY_BUFFER, GL_PIXEL_PACK_BUFFER, and GL_PIXEL_UNPACK_BUFFER are tracked; other targets are passed through)
+	void bind_buffer(GLenum target, GLuint buffer);
+	void active_texture(GLenum unit); //GL_TEXTURE0 + n
+	void bind_texture(GLenum target, GLuint texture); //(GL_TEXTURE_2D is tracked, per unit; other targets are passed through)
+
+	//----- fixed-function state -----
+	//(GL_BLEND and GL_DEPTH_TEST are tracked; other capabilities are passed through)
+	void enable(GLenum cap);
+	void disable(GLenum cap);
+	void blend_func(GLenum sfactor, GLenum dfactor);
+
+	//----- bookkeeping -----
+	//OpenGL resets bindings of deleted objects to zero; these do the same to the shadow state:
+	void deleted_program(GLuint program);
+	void deleted_vertex_array(GLuint vertex_array);
+	void deleted_buffer(GLuint buffer);
+	void deleted_texture(GLuint texture);
+
+	//forget everything (the next call to set each piece of state will always reach OpenGL):
+	void invalidate();
+
+	//counts of state-setting calls that reached OpenGL / that were skipped:
+	uint64_t calls = 0;
+	uint64_t avoided = 0;
+
+	//----- internals -----
+	//NOTE: Unknown marks state that may hold anything.
+	static constexpr GLuint Unknown = ~GLuint(0);
+	static constexpr uint32_t TextureUnits = 16;
+
+	GLuint program = Unknown;
+	GLuint vertex_array = Unknown;
+	GLuint array_buffer = Unknown;
+	GLuint pixel_pack_buffer = Unknown;
+	GLuint pixel_unpack_buffer = Unknown;
+	GLuint texture_unit = Unknown; //as an index, not GL_TEXTUREn
+	GLuint texture_2d[TextureUnits];
+	GLuint blend = Unknown; //GL_TRUE, GL_FALSE, or Unknown
+	GLuint depth_test = Unknown;
+	GLenum blend_sfactor = Unknown, blend_dfactor = Unknown;
+
+	GLState() { invalidate(); }
+
+	//if 'cached' is already 'value', count an avoided call and return false; otherwise update it and return true:
+	bool change(GLuint *cached, GLuint value);
+};
+
+extern GLState gl_state;
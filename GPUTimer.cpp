@@ -0,0 +1,118 @@
+#include "GPUTimer.hpp"
+
+#include "gl_errors.hpp"
+
+#include <cassert>
+
+GPUTimer gpu_timer;
+
+void GPUTimer::release() {
+	for (auto &f : frames) {
+		for (auto const &span : f.spans) {
+			glDeleteQueries(1, &span.begin);
+			glDeleteQueries(1, &span.end);
+		}
+		f.spans.clear();
+		f.used = 0;
+		f.pending = false;
+	}
+	in_frame = false;
+	open.clear();
+}
+
+GPUTimer::Scope::Scope(char const *name) {
+	gpu_timer.begin(name);
+}
+
+GPUTimer::Scope::~Scope() {
+	gpu_timer.end();
+}
+
+void GPUTimer::begin_frame() {
+	assert(!in_frame);
+	Frame &f = frames[frame];
+
+	//this slot's queries were issued Frames frames ago; read them back if they're done, otherwise give up on them:
+	if (f.pending) {
+		collect(f);
+		if (f.pending) {
+			dropped += 1;
+			f.pending = false;
+		}
+	}
+
+	f.used = 0;
+	in_frame = true;
+}
+
+void GPUTimer::end_frame() {
+	assert(in_frame);
+	assert(open.empty() && "every GPUTimer::begin() should have a matching end()");
+	Frame &f = frames[frame];
+	f.pending = (f.used > 0);
+	in_frame = false;
+	frame = (frame + 1) % Frames;
+}
+
+void GPUTimer::begin(char const *name) {
+	if (!in_frame) return;
+	Frame &f = frames[frame];
+	if (f.used == f.spans.size()) {
+		Span span;
+		span.name = name;
+		glGenQueries(1, &span.begin);
+		glGenQueries(1, &span.end);
+		f.spans.emplace_back(span);
+	}
+	Span &span = f.spans[f.used];
+	span.name = name;
+	glQueryCounter(span.begin, GL_TIMESTAMP);
+	open.emplace_back(f.used);
+	f.used += 1;
+}
+
+void GPUTimer::end() {
+	if (!in_frame) return;
+	assert(!open.empty());
+	Frame &f = frames[frame];
+	glQueryCounter(f.spans[open.back()].end, GL_TIMESTAMP);
+	open.pop_back();
+}
+
+void GPUTimer::collect(Frame &f) {
+	assert(f.pending && f.used > 0);
+
+	//check that every query has a result (rather than waiting for one):
+	for (uint32_t i = 0; i < f.used; ++i) {
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(f.spans[i].end, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) return;
+	}
+
+	//sum spans by name:
+	std::vector< double > frame_ms(results.size(), 0.0);
+	for (uint32_t i = 0; i < f.used; ++i) {
+		Span const &span = f.spans[i];
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(span.begin, GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(span.end, GL_QUERY_RESULT, &end);
+
+		uint32_t r = 0;
+		while (r < results.size() && results[r].name != span.name) ++r;
+		if (r == results.size()) {
+			results.emplace_back();
+			results.back().name = span.name;
+			frame_ms.emplace_back(0.0);
+		}
+		frame_ms[r] += (end - begin) / 1.0e6;
+	}
+
+	//smooth (scopes that didn't appear this frame count as zero):
+	for (uint32_t r = 0; r < results.size(); ++r) {
+		results[r].ms += 0.1 * (frame_ms[r] - results[r].ms);
+	}
+
+	f.pending = false;
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+ * GPUTimer measures how long the GPU spends on named sections of each frame,
+ *  using GL_TIMESTAMP queries.
+ *
+ * Query results are read back 'Frames' frames late (and frames whose results
+ *  aren't ready yet are skipped), so timing never makes the CPU wait on the GPU.
+ *
+ * Usage:
+ *   gpu_timer.begin_frame();
+ *   { GPUTimer::Scope scope("draw"); ...gl calls... }
+ *   gpu_timer.end_frame();
+ *   ...later, gpu_timer.results holds smoothed per-scope times.
+ *
+ * Scopes may nest; scopes with the same name in one frame are added together.
+ * Scopes outside of begin_frame() / end_frame() are ignored.
+ */
+
+struct GPUTimer {
+	static constexpr uint32_t Frames = 4;
+
+	GPUTimer() = default;
+
+	GPUTimer(GPUTimer const &) = delete;
+	GPUTimer &operator=(GPUTimer const &) = delete;
+
+	void begin_frame();
+	void end_frame();
+
+	//time the GPU work issued between begin() and the matching end():
+	// ('name' should be a string literal or otherwise outlive the frame)
+	void begin(char const *name);
+	void end();
+
+	struct Scope {
+		Scope(char const *name);
+		~Scope();
+	};
+
+	//per-scope times (exponentially smoothed), in order of first appearance:
+	struct Result {
+		std::string name;
+		double ms = 0.0;
+	};
+	std::vector< Result > results;
+
+	//frames whose results were skipped because they weren't ready in time:
+	uint32_t dropped = 0;
+
+	//free query objects (call before the OpenGL context is destroyed):
+	void release();
+
+	//----- internals -----
+
+	struct Span {
+		char const *name;
+		GLuint begin, end; //timestamp queries
+	};
+	struct Frame {
+		std::vector< Span > spans;
+		uint32_t used = 0; //spans issued this time around
+		bool pending = false; //queries issued but not yet read
+	};
+	Frame frames[Frames];
+	uint32_t frame = 0; //index into frames of the frame being recorded
+	bool in_frame = false;
+	std::vector< uint32_t > open; //indices of spans that have begun but not ended
+
+	void collect(Frame &frame); //read back a frame's results, if available
+};
+
+extern GPUTimer gpu_timer;
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+
+/*
+ * MappedFile maps a whole file into memory, read-only, for as long as it lives.
+ * Reading from it goes straight to the OS page cache, with no stream layer and
+ *  no copy into a separate buffer (pages are loaded on first touch).
+ *
+ * Usage:
+ *   MappedFile file("image.png"); //throws if the file can't be opened or mapped
+ *   load_png(file.data, file.size, ...);
+ */
+
+struct MappedFile {
+	MappedFile(std::string const &filename);
+	~MappedFile();
+
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+
+	uint8_t const *data = nullptr; //(nullptr if the file is empty)
+	size_t size = 0;
+
+	//----- internals -----
+	#ifdef _WIN32
+	void *file = nullptr; //HANDLE of the file
+	void *mapping = nullptr; //HANDLE of the file mapping
+	#endif
+};
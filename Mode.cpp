@@ -1,5 +1,7 @@
 #include "Mode.hpp"
 
+constexpr float Mode::Tick;
+
 std::shared_ptr< Mode > Mode::current;
 
 void Mode::set_current(std::shared_ptr< Mode > const &new_current) {
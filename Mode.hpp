@@ -13,12 +13,18 @@ struct Mode : std::enable_shared_from_this< Mode > {
 	//The function should return 'true' if it handled the event.
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) { return false; }
 
-	//update is called at the start of a new frame, after events are handled:
-	// 'elapsed' is time in seconds since the last call to 'update'
+	//update is called at a fixed rate, after events are handled:
+	// 'elapsed' is the simulation step in seconds (always Mode::Tick when called by the main loop)
+	// (note that this might be several times per frame or never)
 	virtual void update(float elapsed) { }
 
-	//draw is called after update:
-	virtual void draw(glm::uvec2 const &drawable_size) = 0;
+	//draw is called once per frame, after any updates:
+	// 'alpha' in [0,1) is how far real time has advanced past the most recent update, as a fraction of Tick
+	// (modes should draw their state interpolated 'alpha' of the way from the previous update to the current one)
+	virtual void draw(glm::uvec2 const &drawable_size, float alpha) = 0;
+
+	//Mode::Tick is the fixed simulation step used by the main loop:
+	static constexpr float Tick = 1.0f / 120.0f;
 
 	//Mode::current is the Mode to which events are dispatched.
 	// use 'set_current' to change the current Mode (e.g., to switch to a menu)
@@ -0,0 +1,154 @@
+#include "MultiBallGame.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+MultiBallGame::MultiBallGame(uint32_t ball_count, uint64_t seed) : rng(seed) {
+	//scatter balls across the middle of the court, heading left or right at random:
+	auto random = [this]() {
+		return rng() / float(rng.max());
+	};
+	balls.reserve(ball_count);
+	ball_velocities.reserve(ball_count);
+	for (uint32_t i = 0; i < ball_count; ++i) {
+		balls.emplace_back(
+			(random() * 2.0f - 1.0f) * (court_radius.x - 1.0f),
+			(random() * 2.0f - 1.0f) * (court_radius.y - ball_radius.y)
+		);
+		ball_velocities.emplace_back(
+			(random() < 0.5f ? -1.0f : 1.0f),
+			random() * 2.0f - 1.0f
+		);
+	}
+}
+
+void MultiBallGame::update(float elapsed) {
+
+	//----- paddle update -----
+
+	//ai: chase the closest ball headed for the paddle (plus a random offset that changes every so often):
+	auto ai_paddle = [&](glm::vec2 &paddle, float &offset, float &offset_update) {
+		PongGame::update_ai_offset(elapsed, &rng, &offset, &offset_update);
+		float closest = std::numeric_limits< float >::infinity();
+		float target = paddle.y;
+		for (uint32_t i = 0; i < balls.size(); ++i) {
+			float dx = paddle.x - balls[i].x;
+			if (dx * ball_velocities[i].x <= 0.0f) continue; //heading away
+			if (std::abs(dx) < closest) {
+				closest = std::abs(dx);
+				target = balls[i].y + offset;
+			}
+		}
+		PongGame::move_ai_paddle(elapsed, target, &paddle);
+	};
+
+	//right player ai:
+	ai_paddle(right_paddle, ai_offset, ai_offset_update);
+
+	//left player ai (if not being played by a person):
+	if (left_ai) {
+		ai_paddle(left_paddle, left_ai_offset, left_ai_offset_update);
+	}
+
+	//clamp paddles to court:
+	PongGame::clamp_paddle(court_radius, paddle_radius, &right_paddle);
+	PongGame::clamp_paddle(court_radius, paddle_radius, &left_paddle);
+
+	//----- ball update -----
+
+	for (uint32_t i = 0; i < balls.size(); ++i) {
+		balls[i] += elapsed * speed_multiplier * ball_velocities[i];
+	}
+
+	//----- ball vs ball -----
+
+	{ //broadphase: bin balls into grid cells with a counting sort:
+		cell_size = 2.0f * std::max(ball_radius.x, ball_radius.y);
+		grid_size = glm::uvec2(
+			std::max(1, int(std::ceil(2.0f * court_radius.x / cell_size))),
+			std::max(1, int(std::ceil(2.0f * court_radius.y / cell_size)))
+		);
+		uint32_t cells = grid_size.x * grid_size.y;
+
+		ball_cells.resize(balls.size());
+		cell_balls.resize(balls.size());
+		cell_starts.assign(cells + 1, 0);
+
+		//count balls per cell (in cell_starts[c+1]):
+		for (uint32_t i = 0; i < balls.size(); ++i) {
+			int x = int((balls[i].x + court_radius.x) / cell_size);
+			int y = int((balls[i].y + court_radius.y) / cell_size);
+			x = std::max(0, std::min(int(grid_size.x) - 1, x));
+			y = std::max(0, std::min(int(grid_size.y) - 1, y));
+			ball_cells[i] = uint32_t(y) * grid_size.x + uint32_t(x);
+			cell_starts[ball_cells[i] + 1] += 1;
+		}
+		//prefix sum to turn counts into start indices:
+		for (uint32_t c = 0; c < cells; ++c) {
+			cell_starts[c+1] += cell_starts[c];
+		}
+		//scatter, using cell_starts[c] as the insertion point for cell c...
+		for (uint32_t i = 0; i < balls.size(); ++i) {
+			cell_balls[cell_starts[ball_cells[i]]++] = i;
+		}
+		//...which leaves cell_starts[c] at the start of cell c+1, so shift everything back by one:
+		for (uint32_t c = cells; c > 0; --c) {
+			cell_starts[c] = cell_starts[c-1];
+		}
+		cell_starts[0] = 0;
+	}
+
+	pair_tests = 0;
+
+	//narrow phase: boxes that overlap are pushed apart along the axis of least overlap,
+	// and (if approaching) exchange velocity along that axis, as equal masses would:
+	auto ball_vs_ball = [this](uint32_t a, uint32_t b) {
+		pair_tests += 1;
+		glm::vec2 delta = balls[b] - balls[a];
+		glm::vec2 overlap = 2.0f * ball_radius - glm::abs(delta);
+		if (overlap.x <= 0.0f || overlap.y <= 0.0f) return;
+
+		uint32_t axis = (overlap.x < overlap.y ? 0 : 1);
+		float dir = (delta[axis] < 0.0f ? -1.0f : 1.0f);
+		balls[a][axis] -= dir * 0.5f * overlap[axis];
+		balls[b][axis] += dir * 0.5f * overlap[axis];
+		if ((ball_velocities[b][axis] - ball_velocities[a][axis]) * dir < 0.0f) {
+			std::swap(ball_velocities[a][axis], ball_velocities[b][axis]);
+		}
+	};
+
+	//each cell is tested against itself and the four neighbors "after" it, so each pair is tested once:
+	for (uint32_t y = 0; y < grid_size.y; ++y) {
+		for (uint32_t x = 0; x < grid_size.x; ++x) {
+			uint32_t c = y * grid_size.x + x;
+			for (uint32_t ai = cell_starts[c]; ai < cell_starts[c+1]; ++ai) {
+				uint32_t a = cell_balls[ai];
+				//same cell:
+				for (uint32_t bi = ai + 1; bi < cell_starts[c+1]; ++bi) {
+					ball_vs_ball(a, cell_balls[bi]);
+				}
+				//neighboring cells:
+				auto neighbor = [&](int nx, int ny) {
+					if (nx < 0 || nx >= int(grid_size.x) || ny >= int(grid_size.y)) return;
+					uint32_t n = uint32_t(ny) * grid_size.x + uint32_t(nx);
+					for (uint32_t bi = cell_starts[n]; bi < cell_starts[n+1]; ++bi) {
+						ball_vs_ball(a, cell_balls[bi]);
+					}
+				};
+				neighbor(int(x) + 1, int(y));
+				neighbor(int(x) - 1, int(y) + 1);
+				neighbor(int(x), int(y) + 1);
+				neighbor(int(x) + 1, int(y) + 1);
+			}
+		}
+	}
+
+	//---- collision with paddles and walls (as in PongGame) ----
+
+	for (uint32_t i = 0; i < balls.size(); ++i) {
+		PongGame::paddle_vs_ball(left_paddle, paddle_radius, ball_radius, &balls[i], &ball_velocities[i]);
+		PongGame::paddle_vs_ball(right_paddle, paddle_radius, ball_radius, &balls[i], &ball_velocities[i]);
+		PongGame::ball_vs_walls(court_radius, ball_radius, &balls[i], &ball_velocities[i], &left_score, &right_score);
+	}
+}
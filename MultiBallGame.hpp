@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CounterRNG.hpp"
+#include "PongGame.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/*
+ * MultiBallGame is Pong with many (thousands of) balls at once.
+ * Each ball follows the PongGame rules (using PongGame's per-ball helpers) --
+ *  bounces off paddles and the top and bottom walls, scores a point at the
+ *  left or right walls -- on the same court (PongCourt), and balls also
+ *  bounce off each other. Ball-vs-ball tests use a uniform grid (rebuilt every
+ *  step with a counting sort) so the cost stays close to linear in the ball count.
+ * Like PongGame, it does not touch SDL or OpenGL (see MultiBallMode for drawing).
+ */
+
+struct MultiBallGame : PongCourt {
+	MultiBallGame(uint32_t ball_count, uint64_t seed = 0);
+
+	//advance the game by 'elapsed' seconds:
+	void update(float elapsed);
+
+	//----- game state -----
+
+	//(court, paddles: see PongCourt)
+
+	glm::vec2 ball_radius = glm::vec2(0.05f, 0.05f);
+
+	//balls (same velocity convention as PongGame: multiplied by speed_multiplier when moving):
+	std::vector< glm::vec2 > balls;
+	std::vector< glm::vec2 > ball_velocities;
+	float speed_multiplier = 4.0f;
+
+	uint32_t left_score = 0;
+	uint32_t right_score = 0;
+
+	float ai_offset = 0.0f;
+	float ai_offset_update = 0.0f;
+
+	//if set, the left paddle is played by the same AI as the right paddle (instead of by the mouse):
+	bool left_ai = false;
+	float left_ai_offset = 0.0f;
+	float left_ai_offset_update = 0.0f;
+
+	//random numbers for ball placement and the ai offsets:
+	CounterRNG rng;
+
+	//----- broadphase -----
+	//(kept between steps only to avoid reallocating)
+
+	//grid cells are at least one ball across, so touching balls are always in the same or neighboring cells:
+	glm::uvec2 grid_size = glm::uvec2(0);
+	float cell_size = 0.0f;
+	std::vector< uint32_t > ball_cells; //cell index of each ball
+	std::vector< uint32_t > cell_starts; //balls in cell c are cell_balls[cell_starts[c]] .. cell_balls[cell_starts[c+1]-1]
+	std::vector< uint32_t > cell_balls; //ball indices, sorted by cell
+
+	//number of ball pairs given a narrow-phase test in the most recent step (for stress-testing):
+	uint32_t pair_tests = 0;
+};
@@ -0,0 +1,145 @@
+#include "MultiBallMode.hpp"
+
+#include "PongStyle.hpp"
+
+//for the GL_ERRORS() macro:
+#include "gl_errors.hpp"
+
+//redundant state changes are skipped by gl_state:
+#include "GLState.hpp"
+
+//for timing sections of draw() on the GPU:
+#include "GPUTimer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+MultiBallMode::MultiBallMode(uint32_t ball_count) : game(ball_count), draw_rects(GLsizeiptr(sizeof(DrawRects::Rect)) * 2 * (ball_count + 100)) {
+	//(draw_rects starts out big enough for every ball, so it won't need to grow)
+}
+
+MultiBallMode::~MultiBallMode() {
+}
+
+bool MultiBallMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
+
+	if (evt.type == SDL_MOUSEMOTION) {
+		//convert mouse from window pixels (top-left origin, +y is down) to clip space ([-1,1]x[-1,1], +y is up):
+		glm::vec2 clip_mouse = glm::vec2(
+			(evt.motion.x + 0.5f) / window_size.x * 2.0f - 1.0f,
+			(evt.motion.y + 0.5f) / window_size.y *-2.0f + 1.0f
+		);
+		game.left_paddle.y = (clip_to_court * glm::vec3(clip_mouse, 1.0f)).y;
+	}
+
+	return false;
+}
+
+void MultiBallMode::update(float elapsed) {
+
+	//remember state before this step so draw() can interpolate:
+	previous_left_paddle = game.left_paddle;
+	previous_right_paddle = game.right_paddle;
+	previous_balls = game.balls;
+
+	game.update(elapsed);
+}
+
+void MultiBallMode::draw(glm::uvec2 const &drawable_size, float alpha) {
+	//colors and sizes (shared with PongMode):
+	glm::u8vec4 const &fg_color = PongStyle::fg_color;
+	glm::u8vec4 const &shadow_color = PongStyle::shadow_color;
+
+	//score is drawn as pips, but with this many balls the scores climb fast, so only show the last few:
+	const uint32_t max_score_pips = 40;
+
+	//---- interpolate moving objects between the previous and current update ----
+
+	glm::vec2 left_paddle = glm::mix(previous_left_paddle, game.left_paddle, alpha);
+	glm::vec2 right_paddle = glm::mix(previous_right_paddle, game.right_paddle, alpha);
+
+	//---- compute rectangles to draw ----
+
+	//walls and their shadows only depend on the court size, so keep them static (as in PongMode):
+	if (static_court_radius != game.court_radius) {
+		static_court_radius = game.court_radius;
+		draw_rects.set_static(PongStyle::court_walls(game.court_radius));
+	}
+
+	//everything else is written straight into draw_rects:
+	//((paddles + balls) with shadows, plus scores):
+	uint32_t max_rectangles = uint32_t(2 * (2 + game.balls.size()) + 2 * max_score_pips);
+	DrawRects::Rect *rects_begin = draw_rects.map(max_rectangles);
+	DrawRects::Rect *rects = rects_begin;
+
+	//inline helper function for rectangle drawing:
+	auto draw_rectangle = [&rects](glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color) {
+		new (rects++) DrawRects::Rect(center, radius, color);
+	};
+
+	//shadows, then solid objects:
+	uint32_t under_walls = 0; //rectangles drawn before the walls
+	for (uint32_t pass = 0; pass < 2; ++pass) {
+		glm::vec2 s = (pass == 0 ? glm::vec2(0.0f,-PongStyle::shadow_offset) : glm::vec2(0.0f));
+		glm::u8vec4 color = (pass == 0 ? shadow_color : fg_color);
+
+		//paddles:
+		draw_rectangle(left_paddle+s, game.paddle_radius, color);
+		draw_rectangle(right_paddle+s, game.paddle_radius, color);
+
+		//balls:
+		for (uint32_t i = 0; i < game.balls.size(); ++i) {
+			draw_rectangle(glm::mix(previous_balls[i], game.balls[i], alpha)+s, game.ball_radius, color);
+		}
+
+		if (pass == 0) under_walls = uint32_t(rects - rects_begin);
+	}
+
+	//scores:
+	glm::vec2 score_radius = glm::vec2(PongStyle::score_radius);
+	for (uint32_t i = 0; i < std::min(game.left_score, max_score_pips); ++i) {
+		draw_rectangle(PongStyle::score_pip(game.court_radius, true, i), score_radius, fg_color);
+	}
+	for (uint32_t i = 0; i < std::min(game.right_score, max_score_pips); ++i) {
+		draw_rectangle(PongStyle::score_pip(game.court_radius, false, i), score_radius, fg_color);
+	}
+
+	//------ compute court-to-window transform ------
+
+	glm::mat4 court_to_clip = PongStyle::court_to_clip(game.court_radius, drawable_size, &clip_to_court);
+
+	//---- actual drawing ----
+
+	{
+		GPUTimer::Scope gpu_scope("clear");
+		glm::u8vec4 const &bg_color = PongStyle::bg_color;
+		glClearColor(bg_color.r / 255.0f, bg_color.g / 255.0f, bg_color.b / 255.0f, bg_color.a / 255.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+	}
+
+	gl_state.enable(GL_BLEND);
+	gl_state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	gl_state.disable(GL_DEPTH_TEST);
+
+	uint32_t rects_count = uint32_t(rects - rects_begin);
+	assert(rects_count <= max_rectangles);
+	{
+		GPUTimer::Scope gpu_scope("upload");
+		draw_rects.unmap(rects_count);
+	}
+
+	GPUTimer::Scope gpu_scope("draw");
+	gl_push_group("shadows");
+	draw_rects.draw_static(court_to_clip, 0, 4); //wall shadows
+	draw_rects.draw(court_to_clip, 0, under_walls);
+	gl_pop_group();
+
+	gl_push_group("walls and objects");
+	draw_rects.draw_static(court_to_clip, 4, 4); //walls
+	draw_rects.draw(court_to_clip, under_walls, rects_count - under_walls);
+	gl_pop_group();
+	draw_rects.end_frame();
+
+	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
+}
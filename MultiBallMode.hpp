@@ -0,0 +1,46 @@
+#include "DrawRects.hpp"
+#include "MultiBallGame.hpp"
+
+#include "Mode.hpp"
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/*
+ * MultiBallMode plays MultiBallGame: Pong with thousands of balls in the court.
+ * It's mostly useful as a stress scene for simulation and drawing throughput.
+ * (Input and drawing follow PongMode; the mouse moves the left paddle.)
+ */
+
+struct MultiBallMode : Mode {
+	MultiBallMode(uint32_t ball_count);
+	virtual ~MultiBallMode();
+
+	//functions called by main loop:
+	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
+	virtual void update(float elapsed) override;
+	virtual void draw(glm::uvec2 const &drawable_size, float alpha) override;
+
+	//----- game state -----
+
+	MultiBallGame game;
+
+	//----- state at the previous update -----
+	//(draw() interpolates between these and the current state)
+
+	glm::vec2 previous_left_paddle = game.left_paddle;
+	glm::vec2 previous_right_paddle = game.right_paddle;
+	std::vector< glm::vec2 > previous_balls = game.balls;
+
+	//----- opengl assets / helpers ------
+
+	//draws the rectangles that make up everything:
+	DrawRects draw_rects;
+	//court size draw_rects's static walls were built for:
+	glm::vec2 static_court_radius = glm::vec2(-1.0f);
+
+	//matrix that maps from clip coordinates to court-space coordinates:
+	glm::mat3x2 clip_to_court = glm::mat3x2(1.0f);
+};
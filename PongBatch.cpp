@@ -0,0 +1,392 @@
+#include "PongBatch.hpp"
+#include "PongBatchKernel.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PONG_BATCH_X86
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+#ifdef PONG_BATCH_X86
+//SSE2 wrapper for step_lanes (SSE2 is always available on x86-64):
+struct SSE4 {
+	typedef __m128 F;
+	static constexpr uint32_t Width = 4;
+	static F set1(float f) { return _mm_set1_ps(f); }
+	static F load(float const *p) { return _mm_loadu_ps(p); }
+	static void store(float *p, F v) { _mm_storeu_ps(p, v); }
+	static F add(F a, F b) { return _mm_add_ps(a, b); }
+	static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+	static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+	static F div(F a, F b) { return _mm_div_ps(a, b); }
+	//NOTE: argument order chosen to match std::min / std::max exactly:
+	static F min(F a, F b) { return _mm_min_ps(b, a); }
+	static F max(F a, F b) { return _mm_max_ps(b, a); }
+	static F lt(F a, F b) { return _mm_cmplt_ps(a, b); }
+	static F gt(F a, F b) { return _mm_cmpgt_ps(a, b); }
+	static F neq(F a, F b) { return _mm_cmpneq_ps(a, b); }
+	static F bit_and(F a, F b) { return _mm_and_ps(a, b); }
+	static F bit_or(F a, F b) { return _mm_or_ps(a, b); }
+	static F bit_andnot(F a, F b) { return _mm_andnot_ps(a, b); } //(~a) & b
+	static F all() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+	static F select(F mask, F a, F b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	static F abs(F a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	static F neg(F a) { return _mm_xor_ps(_mm_set1_ps(-0.0f), a); }
+	static uint32_t bits(F mask) { return uint32_t(_mm_movemask_ps(mask)); }
+	static void increment(uint32_t *p, F mask) {
+		//mask lanes are -1 (all bits set) where set, so subtracting adds one:
+		__m128i v = _mm_loadu_si128(reinterpret_cast< __m128i const * >(p));
+		v = _mm_sub_epi32(v, _mm_castps_si128(mask));
+		_mm_storeu_si128(reinterpret_cast< __m128i * >(p), v);
+	}
+};
+
+bool cpu_has_avx2() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!(osxsave && avx)) return false;
+	//make sure the OS saves ymm registers:
+	if ((_xgetbv(0) & 0x6) != 0x6) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif //PONG_BATCH_X86
+
+//the one-match-at-a-time version of the update, written to mirror PongGame::update (with continuous_collision cleared) line-by-line:
+void step_scalar(PongBatch &b, float elapsed) {
+	float paddle_min = -b.court_radius.y + b.paddle_radius.y;
+	float paddle_max =  b.court_radius.y - b.paddle_radius.y;
+
+	for (uint32_t i = 0; i < b.count; ++i) {
+		float &ball_x = b.ball_x[i];
+		float &ball_y = b.ball_y[i];
+		float &velocity_x = b.ball_velocity_x[i];
+		float &velocity_y = b.ball_velocity_y[i];
+
+		//----- paddle update -----
+
+		b.ai_offset_update[i] -= elapsed;
+		b.left_ai_offset_update[i] -= elapsed;
+		b.refresh_ai(i, elapsed);
+
+		if (b.predictive_ai && (velocity_x != b.ai_planned_velocity_x[i] || std::abs(velocity_y) != b.ai_planned_velocity_y[i])) {
+			b.plan_ai(i);
+		}
+
+		auto ai_paddle = [&](float &paddle_y, float offset, float target) {
+			float aim = (b.predictive_ai ? target + 0.5f * offset : ball_y + offset);
+			if (paddle_y < aim) {
+				paddle_y = std::min(aim, paddle_y + 2.0f * elapsed);
+			} else {
+				paddle_y = std::max(aim, paddle_y - 2.0f * elapsed);
+			}
+		};
+		ai_paddle(b.right_paddle_y[i], b.ai_offset[i], b.ai_target[i]);
+		ai_paddle(b.left_paddle_y[i], b.left_ai_offset[i], b.left_ai_target[i]);
+
+		//clamp paddles to court:
+		b.right_paddle_y[i] = std::min(std::max(b.right_paddle_y[i], paddle_min), paddle_max);
+		b.left_paddle_y[i] = std::min(std::max(b.left_paddle_y[i], paddle_min), paddle_max);
+
+		//----- ball update -----
+
+		float step = elapsed * b.speed_multiplier[i];
+		ball_x += step * velocity_x;
+		ball_y += step * velocity_y;
+
+		//---- collision handling ----
+
+		//paddles:
+		auto paddle_vs_ball = [&](float paddle_x, float paddle_y) {
+			//compute area of overlap:
+			float min_x = std::max(paddle_x - b.paddle_radius.x, ball_x - b.ball_radius.x);
+			float min_y = std::max(paddle_y - b.paddle_radius.y, ball_y - b.ball_radius.y);
+			float max_x = std::min(paddle_x + b.paddle_radius.x, ball_x + b.ball_radius.x);
+			float max_y = std::min(paddle_y + b.paddle_radius.y, ball_y + b.ball_radius.y);
+
+			//if no overlap, no collision:
+			if (min_x > max_x || min_y > max_y) return;
+
+			if (max_x - min_x > max_y - min_y) {
+				//wider overlap in x => bounce in y direction:
+				if (ball_y > paddle_y) {
+					ball_y = paddle_y + b.paddle_radius.y + b.ball_radius.y;
+					velocity_y = std::abs(velocity_y);
+				} else {
+					ball_y = paddle_y - b.paddle_radius.y - b.ball_radius.y;
+					velocity_y = -std::abs(velocity_y);
+				}
+			} else {
+				//wider overlap in y => bounce in x direction:
+				if (ball_x > paddle_x) {
+					ball_x = paddle_x + b.paddle_radius.x + b.ball_radius.x;
+					velocity_x = std::abs(velocity_x);
+				} else {
+					ball_x = paddle_x - b.paddle_radius.x - b.ball_radius.x;
+					velocity_x = -std::abs(velocity_x);
+				}
+				//warp y velocity based on offset from paddle center:
+				float vel = (ball_y - paddle_y) / (b.paddle_radius.y + b.ball_radius.y);
+				velocity_y = glm::mix(velocity_y, vel, 0.75f);
+			}
+		};
+		paddle_vs_ball(b.left_paddle_x, b.left_paddle_y[i]);
+		paddle_vs_ball(b.right_paddle_x, b.right_paddle_y[i]);
+
+		//court walls:
+		if (ball_y > b.court_radius.y - b.ball_radius.y) {
+			ball_y = b.court_radius.y - b.ball_radius.y;
+			if (velocity_y > 0.0f) {
+				velocity_y = -velocity_y;
+			}
+		}
+		if (ball_y < -b.court_radius.y + b.ball_radius.y) {
+			ball_y = -b.court_radius.y + b.ball_radius.y;
+			if (velocity_y < 0.0f) {
+				velocity_y = -velocity_y;
+			}
+		}
+
+		if (ball_x > b.court_radius.x - b.ball_radius.x) {
+			ball_x = b.court_radius.x - b.ball_radius.x;
+			if (velocity_x > 0.0f) {
+				velocity_x = -velocity_x;
+				b.left_score[i] += 1;
+				b.refresh_speed(i);
+			}
+		}
+		if (ball_x < -b.court_radius.x + b.ball_radius.x) {
+			ball_x = -b.court_radius.x + b.ball_radius.x;
+			if (velocity_x < 0.0f) {
+				velocity_x = -velocity_x;
+				b.right_score[i] += 1;
+				b.refresh_speed(i);
+			}
+		}
+	}
+}
+
+PongBatchLanes lanes_for(PongBatch &b) {
+	PongBatchLanes L;
+	L.count = uint32_t(b.ball_x.size());
+	L.live = b.count;
+
+	L.ball_x = b.ball_x.data();
+	L.ball_y = b.ball_y.data();
+	L.ball_velocity_x = b.ball_velocity_x.data();
+	L.ball_velocity_y = b.ball_velocity_y.data();
+	L.left_paddle_y = b.left_paddle_y.data();
+	L.right_paddle_y = b.right_paddle_y.data();
+	L.left_score = b.left_score.data();
+	L.right_score = b.right_score.data();
+	L.ai_offset = b.ai_offset.data();
+	L.ai_offset_update = b.ai_offset_update.data();
+	L.left_ai_offset = b.left_ai_offset.data();
+	L.left_ai_offset_update = b.left_ai_offset_update.data();
+	L.speed_multiplier = b.speed_multiplier.data();
+
+	L.predictive_ai = b.predictive_ai;
+	L.ai_planned_velocity_x = b.ai_planned_velocity_x.data();
+	L.ai_planned_velocity_y = b.ai_planned_velocity_y.data();
+	L.ai_target = b.ai_target.data();
+	L.left_ai_target = b.left_ai_target.data();
+
+	L.left_paddle_x = b.left_paddle_x;
+	L.right_paddle_x = b.right_paddle_x;
+	L.paddle_radius_x = b.paddle_radius.x;
+	L.paddle_radius_y = b.paddle_radius.y;
+	L.ball_radius_x = b.ball_radius.x;
+	L.ball_radius_y = b.ball_radius.y;
+	L.court_radius_x = b.court_radius.x;
+	L.court_radius_y = b.court_radius.y;
+
+	L.batch = &b;
+	L.refresh_ai = [](PongBatch *batch, uint32_t match, float elapsed) {
+		batch->refresh_ai(match, elapsed);
+	};
+	L.refresh_speed = [](PongBatch *batch, uint32_t match) {
+		batch->refresh_speed(match);
+	};
+	L.plan_ai = [](PongBatch *batch, uint32_t match) {
+		batch->plan_ai(match);
+	};
+	return L;
+}
+
+} //namespace
+
+PongBatch::PongBatch(uint32_t count_, uint64_t seed) : count(count_) {
+	PongGame game;
+	court_radius = game.court_radius;
+	paddle_radius = game.paddle_radius;
+	ball_radius = game.ball_radius;
+	left_paddle_x = game.left_paddle.x;
+	right_paddle_x = game.right_paddle.x;
+
+	uint32_t padded = (count + 7) / 8 * 8;
+	for (auto v : { &ball_x, &ball_y, &ball_velocity_x, &ball_velocity_y, &left_paddle_y, &right_paddle_y,
+		&ai_offset, &ai_offset_update, &left_ai_offset, &left_ai_offset_update, &speed_multiplier,
+		&ai_planned_velocity_x, &ai_planned_velocity_y, &ai_target, &left_ai_target }) {
+		v->resize(padded);
+	}
+	left_score.resize(padded);
+	right_score.resize(padded);
+	ai_plans.resize(padded);
+	rng.resize(padded);
+
+	for (uint32_t i = 0; i < padded; ++i) {
+		game.rng = CounterRNG(seed, i);
+		set(i, game);
+	}
+}
+
+PongBatch::Kernel PongBatch::best_kernel() {
+	if (kernel_supported(AVX2)) return AVX2;
+	if (kernel_supported(SSE)) return SSE;
+	return Scalar;
+}
+
+bool PongBatch::kernel_supported(Kernel kernel) {
+	if (kernel == Scalar) return true;
+#ifdef PONG_BATCH_X86
+	if (kernel == SSE) return true;
+	if (kernel == AVX2) {
+		static bool const has_avx2 = PongBatchAVX2Compiled && cpu_has_avx2();
+		return has_avx2;
+	}
+#endif
+	return false;
+}
+
+char const *PongBatch::kernel_name(Kernel kernel) {
+	if (kernel == Scalar) return "scalar";
+	if (kernel == SSE) return "SSE";
+	if (kernel == AVX2) return "AVX2";
+	return "unknown";
+}
+
+void PongBatch::update(float elapsed, Kernel kernel) {
+	if (!kernel_supported(kernel)) {
+		throw std::runtime_error(std::string("PongBatch: ") + kernel_name(kernel) + " kernel is not supported on this build/CPU.");
+	}
+	if (kernel == Scalar) {
+		step_scalar(*this, elapsed);
+#ifdef PONG_BATCH_X86
+	} else if (kernel == SSE) {
+		step_lanes< SSE4 >(lanes_for(*this), elapsed);
+	} else if (kernel == AVX2) {
+		pong_batch_update_avx2(lanes_for(*this), elapsed);
+#endif
+	}
+}
+
+PongGame PongBatch::get(uint32_t i) const {
+	PongGame game;
+	game.court_radius = court_radius;
+	game.paddle_radius = paddle_radius;
+	game.ball_radius = ball_radius;
+	game.left_paddle = glm::vec2(left_paddle_x, left_paddle_y[i]);
+	game.right_paddle = glm::vec2(right_paddle_x, right_paddle_y[i]);
+	game.ball = glm::vec2(ball_x[i], ball_y[i]);
+	game.ball_velocity = glm::vec2(ball_velocity_x[i], ball_velocity_y[i]);
+	game.left_score = left_score[i];
+	game.right_score = right_score[i];
+	game.ai_offset = ai_offset[i];
+	game.ai_offset_update = ai_offset_update[i];
+	game.continuous_collision = false;
+	game.left_ai = true;
+	game.left_ai_offset = left_ai_offset[i];
+	game.left_ai_offset_update = left_ai_offset_update[i];
+	game.predictive_ai = predictive_ai;
+	game.ai_planned_velocity = glm::vec2(ai_planned_velocity_x[i], ai_planned_velocity_y[i]);
+	game.ai_target = ai_target[i];
+	game.left_ai_target = left_ai_target[i];
+	game.ai_plans = ai_plans[i];
+	game.rng = rng[i];
+	game.reset_trail();
+	return game;
+}
+
+void PongBatch::set(uint32_t i, PongGame const &game) {
+	left_paddle_y[i] = game.left_paddle.y;
+	right_paddle_y[i] = game.right_paddle.y;
+	ball_x[i] = game.ball.x;
+	ball_y[i] = game.ball.y;
+	ball_velocity_x[i] = game.ball_velocity.x;
+	ball_velocity_y[i] = game.ball_velocity.y;
+	left_score[i] = game.left_score;
+	right_score[i] = game.right_score;
+	ai_offset[i] = game.ai_offset;
+	ai_offset_update[i] = game.ai_offset_update;
+	left_ai_offset[i] = game.left_ai_offset;
+	left_ai_offset_update[i] = game.left_ai_offset_update;
+	ai_planned_velocity_x[i] = game.ai_planned_velocity.x;
+	ai_planned_velocity_y[i] = game.ai_planned_velocity.y;
+	ai_target[i] = game.ai_target;
+	left_ai_target[i] = game.left_ai_target;
+	ai_plans[i] = game.ai_plans;
+	rng[i] = game.rng;
+	refresh_speed(i);
+}
+
+void PongBatch::refresh_ai(uint32_t i, float elapsed) {
+	//same draws, in the same order, as PongGame::update:
+	CounterRNG &r = rng[i];
+	if (ai_offset_update[i] < elapsed) {
+		//update again in [0.5,1.0) seconds:
+		ai_offset_update[i] = (r() / float(r.max())) * 0.5f + 0.5f;
+		ai_offset[i] = (r() / float(r.max())) * 2.5f - 1.25f;
+	}
+	if (left_ai_offset_update[i] < elapsed) {
+		left_ai_offset_update[i] = (r() / float(r.max())) * 0.5f + 0.5f;
+		left_ai_offset[i] = (r() / float(r.max())) * 2.5f - 1.25f;
+	}
+}
+
+void PongBatch::refresh_speed(uint32_t i) {
+	//speed of ball doubles every four points:
+	float speed = 4.0f * std::pow(2.0f, (left_score[i] + right_score[i]) / 4.0f);
+
+	//velocity cap, though (otherwise ball can pass through paddles):
+	speed_multiplier[i] = std::min(speed, 10.0f);
+}
+
+void PongBatch::plan_ai(uint32_t i) {
+	//same prediction as PongGame::plan_ai:
+	ai_planned_velocity_x[i] = ball_velocity_x[i];
+	ai_planned_velocity_y[i] = std::abs(ball_velocity_y[i]);
+	ai_plans[i] += 1;
+
+	float min_y = -court_radius.y + ball_radius.y;
+	float max_y =  court_radius.y - ball_radius.y;
+
+	glm::vec2 ball = glm::vec2(ball_x[i], ball_y[i]);
+	glm::vec2 velocity = glm::vec2(ball_velocity_x[i], ball_velocity_y[i]);
+	if (velocity.x > 0.0f) {
+		ai_target[i] = PongGame::predict_ball_y(ball, velocity, right_paddle_x - paddle_radius.x - ball_radius.x, min_y, max_y);
+	} else {
+		ai_target[i] = 0.0f;
+	}
+	if (velocity.x < 0.0f) {
+		left_ai_target[i] = PongGame::predict_ball_y(ball, velocity, left_paddle_x + paddle_radius.x + ball_radius.x, min_y, max_y);
+	} else {
+		left_ai_target[i] = 0.0f;
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "PongGame.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/*
+ * PongBatch steps many independent AI-vs-AI Pong matches at once.
+ * Match state is stored as a structure of arrays (one array per field, one
+ *  entry per match) so that the update can run on several matches per
+ *  instruction with SSE (4 matches) or AVX2 (8 matches) kernels.
+ *
+ * The rules are exactly those of PongGame::update with left_ai set and
+ *  continuous_collision cleared and max_speed_multiplier at its default (i.e., the original overlap test and speed cap);
+ *  the rainbow trail is not simulated since it only matters for drawing.
+ * Setting predictive_ai switches every match to PongGame's predictive ai; its
+ *  predictions are made by scalar code, only for matches whose ball changed direction.
+ */
+
+struct PongBatch {
+	//create 'count' matches, each starting as a default-constructed PongGame would,
+	// except that match i draws random numbers from CounterRNG(seed, i):
+	PongBatch(uint32_t count, uint64_t seed = 0);
+
+	//which implementation of the update to use:
+	enum Kernel {
+		Scalar, //one match at a time
+		SSE, //four matches at a time (x86-64 only)
+		AVX2, //eight matches at a time (x86-64 with AVX2 only)
+	};
+	//fastest kernel supported by this build and CPU:
+	static Kernel best_kernel();
+	static bool kernel_supported(Kernel kernel);
+	static char const *kernel_name(Kernel kernel);
+
+	//advance every match by 'elapsed' seconds:
+	// (throws if 'kernel' is not supported)
+	void update(float elapsed, Kernel kernel = best_kernel());
+
+	//copy a single match to/from a PongGame (for inspection or for seeding a batch):
+	// (get() returns a game with a trail containing just the current ball position)
+	PongGame get(uint32_t match) const;
+	void set(uint32_t match, PongGame const &game);
+
+	//----- shared parameters -----
+	//(initialized from a default PongGame)
+
+	uint32_t count = 0;
+
+	glm::vec2 court_radius;
+	glm::vec2 paddle_radius;
+	glm::vec2 ball_radius;
+
+	float left_paddle_x;
+	float right_paddle_x;
+
+	//use PongGame's predictive ai (see PongGame::predictive_ai) for all matches:
+	bool predictive_ai = false;
+
+	//----- per-match state -----
+	//NOTE: arrays are padded to a multiple of 8 entries so kernels never need a remainder loop.
+
+	std::vector< float > ball_x, ball_y;
+	std::vector< float > ball_velocity_x, ball_velocity_y;
+	std::vector< float > left_paddle_y, right_paddle_y;
+	std::vector< uint32_t > left_score, right_score;
+	std::vector< float > ai_offset, ai_offset_update;
+	std::vector< float > left_ai_offset, left_ai_offset_update;
+
+	//predictive ai state (used only if predictive_ai is set):
+	std::vector< float > ai_planned_velocity_x, ai_planned_velocity_y;
+	std::vector< float > ai_target, left_ai_target;
+	std::vector< uint32_t > ai_plans;
+
+	//ball speed multiplier, derived from the scores (kept here so kernels don't need to call pow):
+	std::vector< float > speed_multiplier;
+
+	//random numbers for ai offsets:
+	std::vector< CounterRNG > rng;
+
+	//internal helpers called by kernels for the (rare) matches that need scalar work:
+	void refresh_ai(uint32_t match, float elapsed); //draw new ai offsets if their timers ran out
+	void refresh_speed(uint32_t match); //recompute speed_multiplier after a point is scored
+	void plan_ai(uint32_t match); //predict ai targets after the ball changes direction
+};
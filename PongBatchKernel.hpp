@@ -0,0 +1,217 @@
+#pragma once
+
+//Vectorized update for PongBatch, shared by PongBatch.cpp (SSE) and PongBatch_avx2.cpp (AVX2).
+//
+//NOTE: PongBatch_avx2.cpp is compiled with AVX2 code generation enabled, so
+// everything it instantiates must stay out of other translation units' reach:
+// the kernel lives in an anonymous namespace, and it only touches plain
+// pointers (no std::vector or glm functions that the linker might share).
+
+#include <stdint.h>
+
+struct PongBatch;
+
+//Raw view of a PongBatch handed to the kernels:
+struct PongBatchLanes {
+	uint32_t count; //padded match count (multiple of 8)
+	uint32_t live; //actual match count; lanes >= live are padding
+
+	float *ball_x, *ball_y;
+	float *ball_velocity_x, *ball_velocity_y;
+	float *left_paddle_y, *right_paddle_y;
+	uint32_t *left_score, *right_score;
+	float *ai_offset, *ai_offset_update;
+	float *left_ai_offset, *left_ai_offset_update;
+	float *speed_multiplier;
+
+	bool predictive_ai;
+	float *ai_planned_velocity_x, *ai_planned_velocity_y;
+	float *ai_target, *left_ai_target;
+
+	float left_paddle_x, right_paddle_x;
+	float paddle_radius_x, paddle_radius_y;
+	float ball_radius_x, ball_radius_y;
+	float court_radius_x, court_radius_y;
+
+	//scalar fix-ups for lanes that need them (see PongBatch::refresh_ai / refresh_speed / plan_ai):
+	PongBatch *batch;
+	void (*refresh_ai)(PongBatch *batch, uint32_t match, float elapsed);
+	void (*refresh_speed)(PongBatch *batch, uint32_t match);
+	void (*plan_ai)(PongBatch *batch, uint32_t match);
+};
+
+//AVX2 kernel, defined in PongBatch_avx2.cpp:
+// (if that file was built without AVX2 support, PongBatchAVX2Compiled is false and the function throws)
+extern bool const PongBatchAVX2Compiled;
+void pong_batch_update_avx2(PongBatchLanes const &lanes, float elapsed);
+
+namespace {
+
+//step_lanes< V > runs PongGame::update (with left_ai set) on V::Width matches at a time.
+// V wraps a SIMD instruction set; see PongBatch.cpp and PongBatch_avx2.cpp.
+//Operations are performed in the same order as the scalar code so results are bit-identical.
+template< typename V >
+void step_lanes(PongBatchLanes const &L, float elapsed) {
+	typedef typename V::F F;
+
+	F const e = V::set1(elapsed);
+	F const paddle_step = V::set1(2.0f * elapsed);
+
+	//limits (computed exactly as the scalar code computes them):
+	F const paddle_min = V::set1(-L.court_radius_y + L.paddle_radius_y);
+	F const paddle_max = V::set1( L.court_radius_y - L.paddle_radius_y);
+	F const ball_min_y = V::set1(-L.court_radius_y + L.ball_radius_y);
+	F const ball_max_y = V::set1( L.court_radius_y - L.ball_radius_y);
+	F const ball_min_x = V::set1(-L.court_radius_x + L.ball_radius_x);
+	F const ball_max_x = V::set1( L.court_radius_x - L.ball_radius_x);
+
+	F const paddle_radius_x = V::set1(L.paddle_radius_x);
+	F const paddle_radius_y = V::set1(L.paddle_radius_y);
+	F const ball_radius_x = V::set1(L.ball_radius_x);
+	F const ball_radius_y = V::set1(L.ball_radius_y);
+	F const warp_radius = V::set1(L.paddle_radius_y + L.ball_radius_y);
+	F const zero = V::set1(0.0f);
+	F const quarter = V::set1(1.0f - 0.75f);
+	F const three_quarters = V::set1(0.75f);
+	F const half = V::set1(0.5f);
+
+	for (uint32_t base = 0; base < L.count; base += V::Width) {
+		//----- paddle update -----
+
+		F right_update = V::sub(V::load(L.ai_offset_update + base), e);
+		F left_update = V::sub(V::load(L.left_ai_offset_update + base), e);
+		V::store(L.ai_offset_update + base, right_update);
+		V::store(L.left_ai_offset_update + base, left_update);
+
+		//offsets that have run out are re-drawn by scalar code, lane by lane (right before left, as in PongGame):
+		uint32_t refresh = V::bits(V::bit_or(V::lt(right_update, e), V::lt(left_update, e)));
+		for (uint32_t lane = 0; refresh; ++lane, refresh >>= 1) {
+			if ((refresh & 1) && base + lane < L.live) L.refresh_ai(L.batch, base + lane, elapsed);
+		}
+
+		F ball_x = V::load(L.ball_x + base);
+		F ball_y = V::load(L.ball_y + base);
+		F velocity_x = V::load(L.ball_velocity_x + base);
+		F velocity_y = V::load(L.ball_velocity_y + base);
+
+		//ai: aim for ball.y + offset, or for the predicted crossing + offset / 2:
+		F right_aim, left_aim;
+		if (L.predictive_ai) {
+			//lanes whose ball changed direction get new targets from scalar code:
+			// (padding lanes included; planning draws no random numbers, so it's harmless there)
+			F stale = V::bit_or(
+				V::neq(velocity_x, V::load(L.ai_planned_velocity_x + base)),
+				V::neq(V::abs(velocity_y), V::load(L.ai_planned_velocity_y + base))
+			);
+			uint32_t plan = V::bits(stale);
+			for (uint32_t lane = 0; plan; ++lane, plan >>= 1) {
+				if (plan & 1) L.plan_ai(L.batch, base + lane);
+			}
+			right_aim = V::add(V::load(L.ai_target + base), V::mul(half, V::load(L.ai_offset + base)));
+			left_aim = V::add(V::load(L.left_ai_target + base), V::mul(half, V::load(L.left_ai_offset + base)));
+		} else {
+			right_aim = V::add(ball_y, V::load(L.ai_offset + base));
+			left_aim = V::add(ball_y, V::load(L.left_ai_offset + base));
+		}
+
+		//move toward aim at a limited speed:
+		auto ai_paddle = [&](F paddle, F aim) {
+			F up = V::min(aim, V::add(paddle, paddle_step));
+			F down = V::max(aim, V::sub(paddle, paddle_step));
+			return V::select(V::lt(paddle, aim), up, down);
+		};
+		F right_paddle_y = ai_paddle(V::load(L.right_paddle_y + base), right_aim);
+		F left_paddle_y = ai_paddle(V::load(L.left_paddle_y + base), left_aim);
+
+		//clamp paddles to court:
+		right_paddle_y = V::min(V::max(right_paddle_y, paddle_min), paddle_max);
+		left_paddle_y = V::min(V::max(left_paddle_y, paddle_min), paddle_max);
+
+		V::store(L.right_paddle_y + base, right_paddle_y);
+		V::store(L.left_paddle_y + base, left_paddle_y);
+
+		//----- ball update -----
+
+		F step = V::mul(e, V::load(L.speed_multiplier + base));
+		ball_x = V::add(ball_x, V::mul(step, velocity_x));
+		ball_y = V::add(ball_y, V::mul(step, velocity_y));
+
+		//---- collision handling ----
+
+		//paddles:
+		auto paddle_vs_ball = [&](F paddle_x, F paddle_y) {
+			//compute area of overlap:
+			F min_x = V::max(V::sub(paddle_x, paddle_radius_x), V::sub(ball_x, ball_radius_x));
+			F min_y = V::max(V::sub(paddle_y, paddle_radius_y), V::sub(ball_y, ball_radius_y));
+			F max_x = V::min(V::add(paddle_x, paddle_radius_x), V::add(ball_x, ball_radius_x));
+			F max_y = V::min(V::add(paddle_y, paddle_radius_y), V::add(ball_y, ball_radius_y));
+
+			//if no overlap, no collision:
+			F hit = V::bit_andnot(V::bit_or(V::gt(min_x, max_x), V::gt(min_y, max_y)), V::all());
+			if (!V::bits(hit)) return;
+
+			//wider overlap in x => bounce in y direction, otherwise bounce in x direction:
+			F wide = V::gt(V::sub(max_x, min_x), V::sub(max_y, min_y));
+			F bounce_y = V::bit_and(hit, wide);
+			F bounce_x = V::bit_andnot(wide, hit);
+
+			F above = V::gt(ball_y, paddle_y);
+			F new_ball_y = V::select(above,
+				V::add(V::add(paddle_y, paddle_radius_y), ball_radius_y),
+				V::sub(V::sub(paddle_y, paddle_radius_y), ball_radius_y));
+			F new_velocity_y = V::select(above, V::abs(velocity_y), V::neg(V::abs(velocity_y)));
+
+			F right_of = V::gt(ball_x, paddle_x);
+			F new_ball_x = V::select(right_of,
+				V::add(V::add(paddle_x, paddle_radius_x), ball_radius_x),
+				V::sub(V::sub(paddle_x, paddle_radius_x), ball_radius_x));
+			F new_velocity_x = V::select(right_of, V::abs(velocity_x), V::neg(V::abs(velocity_x)));
+			//warp y velocity based on offset from paddle center:
+			F warp = V::div(V::sub(ball_y, paddle_y), warp_radius);
+			F warped_velocity_y = V::add(V::mul(velocity_y, quarter), V::mul(warp, three_quarters));
+
+			ball_y = V::select(bounce_y, new_ball_y, ball_y);
+			velocity_y = V::select(bounce_y, new_velocity_y, V::select(bounce_x, warped_velocity_y, velocity_y));
+			ball_x = V::select(bounce_x, new_ball_x, ball_x);
+			velocity_x = V::select(bounce_x, new_velocity_x, velocity_x);
+		};
+		paddle_vs_ball(V::set1(L.left_paddle_x), left_paddle_y);
+		paddle_vs_ball(V::set1(L.right_paddle_x), right_paddle_y);
+
+		//court walls:
+		F top = V::gt(ball_y, ball_max_y);
+		ball_y = V::select(top, ball_max_y, ball_y);
+		velocity_y = V::select(V::bit_and(top, V::gt(velocity_y, zero)), V::neg(velocity_y), velocity_y);
+
+		F bottom = V::lt(ball_y, ball_min_y);
+		ball_y = V::select(bottom, ball_min_y, ball_y);
+		velocity_y = V::select(V::bit_and(bottom, V::lt(velocity_y, zero)), V::neg(velocity_y), velocity_y);
+
+		F right = V::gt(ball_x, ball_max_x);
+		ball_x = V::select(right, ball_max_x, ball_x);
+		F left_point = V::bit_and(right, V::gt(velocity_x, zero));
+		velocity_x = V::select(left_point, V::neg(velocity_x), velocity_x);
+
+		F left = V::lt(ball_x, ball_min_x);
+		ball_x = V::select(left, ball_min_x, ball_x);
+		F right_point = V::bit_and(left, V::lt(velocity_x, zero));
+		velocity_x = V::select(right_point, V::neg(velocity_x), velocity_x);
+
+		V::store(L.ball_x + base, ball_x);
+		V::store(L.ball_y + base, ball_y);
+		V::store(L.ball_velocity_x + base, velocity_x);
+		V::store(L.ball_velocity_y + base, velocity_y);
+
+		//scores:
+		uint32_t scored = V::bits(V::bit_or(left_point, right_point));
+		if (scored) {
+			V::increment(L.left_score + base, left_point);
+			V::increment(L.right_score + base, right_point);
+			for (uint32_t lane = 0; scored; ++lane, scored >>= 1) {
+				if ((scored & 1) && base + lane < L.live) L.refresh_speed(L.batch, base + lane);
+			}
+		}
+	}
+}
+
+} //namespace
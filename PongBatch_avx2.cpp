@@ -0,0 +1,65 @@
+//AVX2 version of the PongBatch update.
+//This file is compiled with AVX2 code generation enabled (see AVX2_FLAGS in the Jamfile),
+// so it must only be called after checking that the CPU supports AVX2 (PongBatch::kernel_supported does this).
+//It deliberately includes nothing but the kernel header and intrinsics; see the note in PongBatchKernel.hpp.
+
+#include "PongBatchKernel.hpp"
+
+#ifdef __AVX2__
+
+#include <immintrin.h>
+
+namespace {
+
+//AVX2 wrapper for step_lanes:
+struct AVX8 {
+	typedef __m256 F;
+	static constexpr uint32_t Width = 8;
+	static F set1(float f) { return _mm256_set1_ps(f); }
+	static F load(float const *p) { return _mm256_loadu_ps(p); }
+	static void store(float *p, F v) { _mm256_storeu_ps(p, v); }
+	static F add(F a, F b) { return _mm256_add_ps(a, b); }
+	static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+	static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+	static F div(F a, F b) { return _mm256_div_ps(a, b); }
+	//NOTE: argument order chosen to match std::min / std::max exactly:
+	static F min(F a, F b) { return _mm256_min_ps(b, a); }
+	static F max(F a, F b) { return _mm256_max_ps(b, a); }
+	static F lt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static F gt(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static F neq(F a, F b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+	static F bit_and(F a, F b) { return _mm256_and_ps(a, b); }
+	static F bit_or(F a, F b) { return _mm256_or_ps(a, b); }
+	static F bit_andnot(F a, F b) { return _mm256_andnot_ps(a, b); } //(~a) & b
+	static F all() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+	static F select(F mask, F a, F b) { return _mm256_blendv_ps(b, a, mask); }
+	static F abs(F a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+	static F neg(F a) { return _mm256_xor_ps(_mm256_set1_ps(-0.0f), a); }
+	static uint32_t bits(F mask) { return uint32_t(_mm256_movemask_ps(mask)); }
+	static void increment(uint32_t *p, F mask) {
+		//mask lanes are -1 (all bits set) where set, so subtracting adds one:
+		__m256i v = _mm256_loadu_si256(reinterpret_cast< __m256i const * >(p));
+		v = _mm256_sub_epi32(v, _mm256_castps_si256(mask));
+		_mm256_storeu_si256(reinterpret_cast< __m256i * >(p), v);
+	}
+};
+
+} //namespace
+
+bool const PongBatchAVX2Compiled = true;
+
+void pong_batch_update_avx2(PongBatchLanes const &lanes, float elapsed) {
+	step_lanes< AVX8 >(lanes, elapsed);
+}
+
+#else //__AVX2__
+
+#include <stdexcept>
+
+bool const PongBatchAVX2Compiled = false;
+
+void pong_batch_update_avx2(PongBatchLanes const &, float) {
+	throw std::runtime_error("PongBatch: built without AVX2 support.");
+}
+
+#endif //__AVX2__
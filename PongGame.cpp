@@ -0,0 +1,294 @@
+#include "PongGame.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+PongGame::PongGame() {
+	reset_trail();
+}
+
+void PongGame::reset_trail() {
+	ball_trail.clear();
+	ball_trail.push(ball, time - 2.0f * trail_length);
+	ball_trail.push(ball, time);
+}
+
+float PongGame::predict_ball_y(glm::vec2 const &ball, glm::vec2 const &velocity, float x, float min_y, float max_y) {
+	if (velocity.x == 0.0f) return ball.y;
+	//time (in units of velocity) until the ball reaches x:
+	float t = (x - ball.x) / velocity.x;
+	if (!(t > 0.0f)) return ball.y;
+
+	//height it would reach with no walls:
+	float y = ball.y + velocity.y * t;
+
+	//bouncing between the walls makes the path repeat every 2*span, reflected in the second half:
+	float span = max_y - min_y;
+	if (!(span > 0.0f)) return ball.y;
+	float u = std::fmod(y - min_y, 2.0f * span);
+	if (u < 0.0f) u += 2.0f * span;
+	if (u > span) u = 2.0f * span - u;
+	return min_y + u;
+}
+
+void PongGame::update_ai_offset(float elapsed, CounterRNG *rng, float *offset, float *offset_update) {
+	*offset_update -= elapsed;
+	if (*offset_update < elapsed) {
+		//update again in [0.5,1.0) seconds:
+		*offset_update = ((*rng)() / float(rng->max())) * 0.5f + 0.5f;
+		*offset = ((*rng)() / float(rng->max())) * 2.5f - 1.25f;
+	}
+}
+
+void PongGame::move_ai_paddle(float elapsed, float aim, glm::vec2 *paddle) {
+	if (paddle->y < aim) {
+		paddle->y = std::min(aim, paddle->y + 2.0f * elapsed);
+	} else {
+		paddle->y = std::max(aim, paddle->y - 2.0f * elapsed);
+	}
+}
+
+void PongGame::clamp_paddle(glm::vec2 const &court_radius, glm::vec2 const &paddle_radius, glm::vec2 *paddle) {
+	paddle->y = std::max(paddle->y, -court_radius.y + paddle_radius.y);
+	paddle->y = std::min(paddle->y,  court_radius.y - paddle_radius.y);
+}
+
+void PongGame::bounce_off_paddle(glm::vec2 const &paddle, glm::vec2 const &paddle_radius, glm::vec2 const &ball_radius, bool in_y, glm::vec2 *ball_, glm::vec2 *velocity_) {
+	glm::vec2 &ball = *ball_;
+	glm::vec2 &velocity = *velocity_;
+	if (in_y) {
+		if (ball.y > paddle.y) {
+			ball.y = paddle.y + paddle_radius.y + ball_radius.y;
+			velocity.y = std::abs(velocity.y);
+		} else {
+			ball.y = paddle.y - paddle_radius.y - ball_radius.y;
+			velocity.y = -std::abs(velocity.y);
+		}
+	} else {
+		if (ball.x > paddle.x) {
+			ball.x = paddle.x + paddle_radius.x + ball_radius.x;
+			velocity.x = std::abs(velocity.x);
+		} else {
+			ball.x = paddle.x - paddle_radius.x - ball_radius.x;
+			velocity.x = -std::abs(velocity.x);
+		}
+		//warp y velocity based on offset from paddle center:
+		float vel = (ball.y - paddle.y) / (paddle_radius.y + ball_radius.y);
+		velocity.y = glm::mix(velocity.y, vel, 0.75f);
+	}
+}
+
+void PongGame::paddle_vs_ball(glm::vec2 const &paddle, glm::vec2 const &paddle_radius, glm::vec2 const &ball_radius, glm::vec2 *ball, glm::vec2 *velocity) {
+	//compute area of overlap:
+	glm::vec2 min = glm::max(paddle - paddle_radius, *ball - ball_radius);
+	glm::vec2 max = glm::min(paddle + paddle_radius, *ball + ball_radius);
+
+	//if no overlap, no collision:
+	if (min.x > max.x || min.y > max.y) return;
+
+	//wider overlap in x => bounce in y direction, otherwise bounce in x direction:
+	bounce_off_paddle(paddle, paddle_radius, ball_radius, max.x - min.x > max.y - min.y, ball, velocity);
+}
+
+void PongGame::ball_vs_walls(glm::vec2 const &court_radius, glm::vec2 const &ball_radius, glm::vec2 *ball_, glm::vec2 *velocity_, uint32_t *left_score, uint32_t *right_score) {
+	glm::vec2 &ball = *ball_;
+	glm::vec2 &velocity = *velocity_;
+
+	if (ball.y > court_radius.y - ball_radius.y) {
+		ball.y = court_radius.y - ball_radius.y;
+		if (velocity.y > 0.0f) {
+			velocity.y = -velocity.y;
+		}
+	}
+	if (ball.y < -court_radius.y + ball_radius.y) {
+		ball.y = -court_radius.y + ball_radius.y;
+		if (velocity.y < 0.0f) {
+			velocity.y = -velocity.y;
+		}
+	}
+
+	if (ball.x > court_radius.x - ball_radius.x) {
+		ball.x = court_radius.x - ball_radius.x;
+		if (velocity.x > 0.0f) {
+			velocity.x = -velocity.x;
+			*left_score += 1;
+		}
+	}
+	if (ball.x < -court_radius.x + ball_radius.x) {
+		ball.x = -court_radius.x + ball_radius.x;
+		if (velocity.x < 0.0f) {
+			velocity.x = -velocity.x;
+			*right_score += 1;
+		}
+	}
+}
+
+void PongGame::plan_ai() {
+	ai_planned_velocity = glm::vec2(ball_velocity.x, std::abs(ball_velocity.y));
+	ai_plans += 1;
+
+	float min_y = -court_radius.y + ball_radius.y;
+	float max_y =  court_radius.y - ball_radius.y;
+
+	//each paddle heads for where the ball will reach its face, or back to the middle if the ball is heading away:
+	if (ball_velocity.x > 0.0f) {
+		ai_target = predict_ball_y(ball, ball_velocity, right_paddle.x - paddle_radius.x - ball_radius.x, min_y, max_y);
+	} else {
+		ai_target = 0.0f;
+	}
+	if (ball_velocity.x < 0.0f) {
+		left_ai_target = predict_ball_y(ball, ball_velocity, left_paddle.x + paddle_radius.x + ball_radius.x, min_y, max_y);
+	} else {
+		left_ai_target = 0.0f;
+	}
+}
+
+void PongGame::update(float elapsed) {
+
+	time += elapsed;
+
+	//----- paddle update -----
+
+	//predictive ai re-plans only when the ball has changed direction (wall bounces are already part of the prediction):
+	if (predictive_ai && (ball_velocity.x != ai_planned_velocity.x || std::abs(ball_velocity.y) != ai_planned_velocity.y)) {
+		plan_ai();
+	}
+
+	//ai: chase the ball -- or the predicted crossing point -- (plus a random offset that changes every so often):
+	auto ai_paddle = [&](glm::vec2 &paddle, float &offset, float &offset_update, float target) {
+		update_ai_offset(elapsed, &rng, &offset, &offset_update);
+		//(predictive ai uses half the offset, so it still hits the ball, just not always square)
+		float aim = (predictive_ai ? target + 0.5f * offset : ball.y + offset);
+		move_ai_paddle(elapsed, aim, &paddle);
+	};
+
+	//right player ai:
+	ai_paddle(right_paddle, ai_offset, ai_offset_update, ai_target);
+
+	//left player ai (if not being played by a person):
+	if (left_ai) {
+		ai_paddle(left_paddle, left_ai_offset, left_ai_offset_update, left_ai_target);
+	}
+
+	//clamp paddles to court:
+	clamp_paddle(court_radius, paddle_radius, &right_paddle);
+	clamp_paddle(court_radius, paddle_radius, &left_paddle);
+
+	//----- ball update -----
+
+	//speed of ball doubles every four points:
+	float speed_multiplier = 4.0f * std::pow(2.0f, (left_score + right_score) / 4.0f);
+
+	//velocity cap, though (otherwise ball can pass through paddles, or -- when swept -- just get silly):
+	speed_multiplier = std::min(speed_multiplier, max_speed_multiplier);
+
+	//---- collision handling ----
+
+	if (continuous_collision) {
+		//paddles move before the ball does, so first push the ball out of any paddle that moved into it:
+		paddle_vs_ball(left_paddle, paddle_radius, ball_radius, &ball, &ball_velocity);
+		paddle_vs_ball(right_paddle, paddle_radius, ball_radius, &ball, &ball_velocity);
+
+		//then sweep the ball along its path, bouncing off whatever it reaches first, until the step is used up:
+		float remaining = elapsed;
+		for (uint32_t bounce = 0; bounce < max_bounces && remaining > 0.0f; ++bounce) {
+			glm::vec2 move = remaining * speed_multiplier * ball_velocity;
+
+			//earliest contact along 'move', as a fraction of 'move':
+			float hit_t = 1.0f;
+			enum { Nothing, Paddle, TopWall, BottomWall, RightWall, LeftWall } hit = Nothing;
+			glm::vec2 const *hit_paddle = nullptr;
+			bool hit_in_y = false;
+
+			//paddles: slab test of the ball's center against the paddle grown by the ball's radius:
+			auto sweep_vs_paddle = [&](glm::vec2 const &paddle) {
+				glm::vec2 lo = paddle - paddle_radius - ball_radius;
+				glm::vec2 hi = paddle + paddle_radius + ball_radius;
+				float enter = -std::numeric_limits< float >::infinity();
+				float exit = std::numeric_limits< float >::infinity();
+				bool enter_in_y = false;
+				for (uint32_t c = 0; c < 2; ++c) {
+					if (move[c] == 0.0f) {
+						//not moving on this axis, so either always inside the slab or never:
+						if (ball[c] < lo[c] || ball[c] > hi[c]) return;
+						continue;
+					}
+					float t0 = (lo[c] - ball[c]) / move[c];
+					float t1 = (hi[c] - ball[c]) / move[c];
+					if (t0 > t1) std::swap(t0, t1);
+					if (t0 > enter) {
+						enter = t0;
+						enter_in_y = (c == 1);
+					}
+					exit = std::min(exit, t1);
+				}
+				//NOTE: contact must start during this move, and a ball resting on a face while moving away is not a hit:
+				if (enter < 0.0f || enter >= exit || enter >= hit_t) return;
+				hit_t = enter;
+				hit = Paddle;
+				hit_paddle = &paddle;
+				hit_in_y = enter_in_y;
+			};
+			sweep_vs_paddle(left_paddle);
+			sweep_vs_paddle(right_paddle);
+
+			//court walls:
+			auto sweep_vs_wall = [&](float position, float limit, float delta, decltype(hit) wall) {
+				if (delta == 0.0f) return;
+				float t = (limit - position) / delta;
+				if (t < 0.0f || t >= hit_t) return;
+				hit_t = t;
+				hit = wall;
+			};
+			if (move.y > 0.0f) sweep_vs_wall(ball.y, court_radius.y - ball_radius.y, move.y, TopWall);
+			if (move.y < 0.0f) sweep_vs_wall(ball.y, -court_radius.y + ball_radius.y, move.y, BottomWall);
+			if (move.x > 0.0f) sweep_vs_wall(ball.x, court_radius.x - ball_radius.x, move.x, RightWall);
+			if (move.x < 0.0f) sweep_vs_wall(ball.x, -court_radius.x + ball_radius.x, move.x, LeftWall);
+
+			//advance to the contact (or the end of the step):
+			ball += hit_t * move;
+			remaining -= hit_t * remaining;
+
+			//bounce (walls are handled just as the discrete wall checks below handle them):
+			if (hit == Paddle) {
+				bounce_off_paddle(*hit_paddle, paddle_radius, ball_radius, hit_in_y, &ball, &ball_velocity);
+			} else if (hit == TopWall) {
+				ball.y = court_radius.y - ball_radius.y;
+				ball_velocity.y = -ball_velocity.y;
+			} else if (hit == BottomWall) {
+				ball.y = -court_radius.y + ball_radius.y;
+				ball_velocity.y = -ball_velocity.y;
+			} else if (hit == RightWall) {
+				ball.x = court_radius.x - ball_radius.x;
+				ball_velocity.x = -ball_velocity.x;
+				left_score += 1;
+			} else if (hit == LeftWall) {
+				ball.x = -court_radius.x + ball_radius.x;
+				ball_velocity.x = -ball_velocity.x;
+				right_score += 1;
+			} else {
+				break;
+			}
+		}
+		//NOTE: if the ball bounces more than max_bounces times in one step, the rest of its motion for the step is dropped.
+	} else {
+		ball += elapsed * speed_multiplier * ball_velocity;
+
+		//paddles (discrete test; resolves any overlap that exists right now):
+		paddle_vs_ball(left_paddle, paddle_radius, ball_radius, &ball, &ball_velocity);
+		paddle_vs_ball(right_paddle, paddle_radius, ball_radius, &ball, &ball_velocity);
+	}
+
+	//court walls:
+	ball_vs_walls(court_radius, ball_radius, &ball, &ball_velocity, &left_score, &right_score);
+
+	//----- rainbow trails -----
+
+	//store fresh location at back of ball trail:
+	ball_trail.push(ball, time);
+
+	//trim any too-old locations from front of trail:
+	//NOTE: drawing may look up to one step further back than trail_length, when interpolating between updates.
+	ball_trail.trim(time - (trail_length + elapsed));
+}
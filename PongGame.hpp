@@ -0,0 +1,138 @@
+#pragma once
+
+#include "BallTrail.hpp"
+#include "CounterRNG.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstring>
+#include <type_traits>
+
+/*
+ * PongCourt is the court and paddle layout, shared by PongState and MultiBallGame
+ *  (so both games are played on the same court).
+ */
+
+struct PongCourt {
+	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f);
+	glm::vec2 paddle_radius = glm::vec2(0.2f, 1.0f);
+
+	glm::vec2 left_paddle = glm::vec2(-court_radius.x + 0.5f, 0.0f);
+	glm::vec2 right_paddle = glm::vec2( court_radius.x - 0.5f, 0.0f);
+};
+
+/*
+ * PongState is everything about a Pong match that changes as it's played (or that
+ *  the rules read), as a plain value: no pointers, no heap storage, trivially copyable.
+ * So a match can be saved and put back with a single memcpy (see PongGame::snapshot
+ *  and PongGame::restore), e.g. for rollback, lookahead, or stepping back in time.
+ */
+
+struct PongState : PongCourt {
+
+	glm::vec2 ball_radius = glm::vec2(0.2f, 0.2f);
+
+	glm::vec2 ball = glm::vec2(0.0f, 0.0f);
+	glm::vec2 ball_velocity = glm::vec2(-1.0f, 0.0f);
+
+	uint32_t left_score = 0;
+	uint32_t right_score = 0;
+
+	float ai_offset = 0.0f;
+	float ai_offset_update = 0.0f;
+
+	//if set, the ball is swept along its path each step, so it can't pass through paddles at any speed;
+	// otherwise the original overlap test is used:
+	bool continuous_collision = true;
+	//ball speed doubles every four points, up to this multiple:
+	// (the default keeps the game playable; with continuous_collision it can be raised -- e.g., for
+	//  long headless runs -- but without it, balls much faster than this pass through paddles)
+	float max_speed_multiplier = 10.0f;
+	//most bounces the sweep will resolve in one step:
+	uint32_t max_bounces = 16;
+
+	//if set, the left paddle is played by the same AI as the right paddle (instead of by the mouse):
+	bool left_ai = false;
+	float left_ai_offset = 0.0f;
+	float left_ai_offset_update = 0.0f;
+
+	//if set, ai paddles head for where the ball will cross them instead of chasing its current height;
+	// the crossing is predicted in closed form (folding in wall bounces) only when the ball changes
+	// direction, i.e. after hitting a paddle or scoring, so the per-step cost is the same as chasing:
+	bool predictive_ai = false;
+	glm::vec2 ai_planned_velocity = glm::vec2(0.0f); //(x, |y|) of ball_velocity when the targets were predicted
+	float ai_target = 0.0f; //right paddle
+	float left_ai_target = 0.0f;
+	uint32_t ai_plans = 0; //number of predictions made so far
+
+	//random numbers for the ai offsets:
+	// (give each match its own stream -- e.g., CounterRNG(seed, match_index) -- for independent, reproducible matches)
+	CounterRNG rng;
+
+	//time (in seconds) simulated so far:
+	double time = 0.0;
+
+	//----- pretty rainbow trails -----
+
+	float trail_length = 1.3f;
+	BallTrail ball_trail; //ball positions stamped with 'time', oldest first
+};
+
+static_assert(std::is_trivially_copyable< PongState >::value, "PongState must stay memcpy-able (no pointers to owned storage, no containers).");
+
+/*
+ * PongGame holds the state of one Pong match along with the rules that advance it.
+ * It does not touch SDL or OpenGL, so matches can be created and stepped without
+ *  a window or context (e.g., by the 'pong-headless' tool in headless.cpp).
+ * PongMode wraps a PongGame with input handling and drawing.
+ */
+
+struct PongGame : PongState {
+	PongGame();
+
+	//advance the match by 'elapsed' seconds:
+	void update(float elapsed);
+
+	//set up trail as if ball has been at its current position 'forever':
+	void reset_trail();
+
+	//predict ai_target and left_ai_target from the ball's current position and direction:
+	void plan_ai();
+
+	//height at which a ball at 'ball' moving along 'velocity' reaches x = 'x', bouncing between heights 'min_y' and 'max_y':
+	// (returns ball.y if the ball won't reach 'x')
+	static float predict_ball_y(glm::vec2 const &ball, glm::vec2 const &velocity, float x, float min_y, float max_y);
+
+	//----- rules for one ball or paddle -----
+	//(shared with MultiBallGame, which applies them to each of its balls)
+
+	//every so often, pick a new random offset for an ai paddle's aim:
+	static void update_ai_offset(float elapsed, CounterRNG *rng, float *offset, float *offset_update);
+	//move an ai paddle toward height 'aim' (at the ai's top speed):
+	static void move_ai_paddle(float elapsed, float aim, glm::vec2 *paddle);
+	//keep a paddle inside the court:
+	static void clamp_paddle(glm::vec2 const &court_radius, glm::vec2 const &paddle_radius, glm::vec2 *paddle);
+
+	//put a ball touching 'paddle' against it and bounce it away:
+	// (in_y: off the top or bottom of the paddle; otherwise off its face, with the y velocity warped by where it hit)
+	static void bounce_off_paddle(glm::vec2 const &paddle, glm::vec2 const &paddle_radius, glm::vec2 const &ball_radius, bool in_y, glm::vec2 *ball, glm::vec2 *velocity);
+	//bounce a ball off 'paddle' if they overlap right now (bouncing along the axis of least overlap):
+	static void paddle_vs_ball(glm::vec2 const &paddle, glm::vec2 const &paddle_radius, glm::vec2 const &ball_radius, glm::vec2 *ball, glm::vec2 *velocity);
+	//keep a ball inside the court: bounce off the top and bottom walls, and off the left or right wall (scoring a point for the other side):
+	static void ball_vs_walls(glm::vec2 const &court_radius, glm::vec2 const &ball_radius, glm::vec2 *ball, glm::vec2 *velocity, uint32_t *left_score, uint32_t *right_score);
+
+	//----- saving and restoring -----
+	//(straight memcpy of the state; no allocation)
+
+	void snapshot(PongState *into) const {
+		std::memcpy(into, static_cast< PongState const * >(this), sizeof(PongState));
+	}
+	PongState snapshot() const {
+		PongState ret;
+		snapshot(&ret);
+		return ret;
+	}
+	void restore(PongState const &from) {
+		std::memcpy(static_cast< PongState * >(this), &from, sizeof(PongState));
+	}
+};
@@ -1,15 +1,18 @@
-#include "ColorTextureProgram.hpp"
+#include "DrawRects.hpp"
+#include "PongGame.hpp"
+#include "Replay.hpp"
 
 #include "Mode.hpp"
 #include "GL.hpp"
 
 #include <glm/glm.hpp>
 
+#include <string>
 #include <vector>
-#include <deque>
 
 /*
  * PongMode is a game mode that implements a single-player game of Pong.
+ * The rules live in PongGame; PongMode handles input and drawing.
  */
 
 struct PongMode : Mode {
@@ -19,54 +22,46 @@ struct PongMode : Mode {
 	//functions called by main loop:
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
 	virtual void update(float elapsed) override;
-	virtual void draw(glm::uvec2 const &drawable_size) override;
+	virtual void draw(glm::uvec2 const &drawable_size, float alpha) override;
 
 	//----- game state -----
 
-	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f);
-	glm::vec2 paddle_radius = glm::vec2(0.2f, 1.0f);
-	glm::vec2 ball_radius = glm::vec2(0.2f, 0.2f);
+	//the match itself (positions, scores, ai, trail):
+	PongGame game;
 
-	glm::vec2 left_paddle = glm::vec2(-court_radius.x + 0.5f, 0.0f);
-	glm::vec2 right_paddle = glm::vec2( court_radius.x - 0.5f, 0.0f);
+	//----- replays -----
 
-	glm::vec2 ball = glm::vec2(0.0f, 0.0f);
-	glm::vec2 ball_velocity = glm::vec2(-1.0f, 0.0f);
+	//start the match over, recording its input (saved to 'filename' when the mode is destroyed):
+	void start_recording(std::string const &filename, uint64_t seed);
+	//start the match over, taking input from 'replay' instead of the mouse:
+	void start_playback(Replay const &replay);
 
-	uint32_t left_score = 0;
-	uint32_t right_score = 0;
+	std::string record_filename; //(recording if not empty)
+	Replay recording;
 
-	float ai_offset = 0.0f;
-	float ai_offset_update = 0.0f;
+	bool playing_back = false;
+	Replay playback;
+	uint32_t playback_step = 0; //next step of 'playback' to run
 
-	//----- pretty rainbow trails -----
+	//----- state at the previous update -----
+	//(draw() interpolates between these and the current state)
 
-	float trail_length = 1.3f;
-	std::deque< glm::vec3 > ball_trail; //stores (x,y,age), oldest elements first
+	glm::vec2 previous_left_paddle = game.left_paddle;
+	glm::vec2 previous_right_paddle = game.right_paddle;
+	glm::vec2 previous_ball = game.ball;
 
 	//----- opengl assets / helpers ------
 
-	//draw functions will work on vectors of vertices, defined as follows:
-	struct Vertex {
-		Vertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
-			Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
-		glm::vec3 Position;
-		glm::u8vec4 Color;
-		glm::vec2 TexCoord;
-	};
-	static_assert(sizeof(Vertex) == 4*3 + 1*4 + 4*2, "PongMode::Vertex should be packed");
-
-	//Shader program that draws transformed, vertices tinted with vertex colors:
-	ColorTextureProgram color_texture_program;
-
-	//Buffer used to hold vertex data during drawing:
-	GLuint vertex_buffer = 0;
+	//draws the rectangles that make up everything:
+	DrawRects draw_rects;
 
-	//Vertex Array Object that maps buffer locations to color_texture_program attribute locations:
-	GLuint vertex_buffer_for_color_texture_program = 0;
-
-	//Solid white texture:
-	GLuint white_tex = 0;
+	//layout of draw_rects's static rectangles:
+	enum : uint32_t {
+		StaticWallShadows = 0, //four wall shadows...
+		StaticWalls = 4, //...then four walls
+	};
+	//court size the static rectangles were built for (they are rebuilt when it changes):
+	glm::vec2 static_court_radius = glm::vec2(-1.0f);
 
 	//matrix that maps from clip coordinates to court-space coordinates:
 	glm::mat3x2 clip_to_court = glm::mat3x2(1.0f);
@@ -0,0 +1,86 @@
+#include "PongStyle.hpp"
+
+#include <algorithm>
+
+#define HEX_TO_U8VEC4( HX ) (glm::u8vec4( (HX >> 24) & 0xff, (HX >> 16) & 0xff, (HX >> 8) & 0xff, (HX) & 0xff ))
+glm::u8vec4 const PongStyle::bg_color = HEX_TO_U8VEC4(0x171714ff);
+glm::u8vec4 const PongStyle::fg_color = HEX_TO_U8VEC4(0xd1bb54ff);
+glm::u8vec4 const PongStyle::shadow_color = HEX_TO_U8VEC4(0x604d29ff);
+std::vector< glm::u8vec4 > const PongStyle::rainbow_colors = {
+	HEX_TO_U8VEC4(0x604d29ff), HEX_TO_U8VEC4(0x624f29fc), HEX_TO_U8VEC4(0x69542df2),
+	HEX_TO_U8VEC4(0x6a552df1), HEX_TO_U8VEC4(0x6b562ef0), HEX_TO_U8VEC4(0x6b562ef0),
+	HEX_TO_U8VEC4(0x6d572eed), HEX_TO_U8VEC4(0x6f592feb), HEX_TO_U8VEC4(0x725b31e7),
+	HEX_TO_U8VEC4(0x745d31e3), HEX_TO_U8VEC4(0x755e32e0), HEX_TO_U8VEC4(0x765f33de),
+	HEX_TO_U8VEC4(0x7a6234d8), HEX_TO_U8VEC4(0x826838ca), HEX_TO_U8VEC4(0x977840a4),
+	HEX_TO_U8VEC4(0x96773fa5), HEX_TO_U8VEC4(0xa07f4493), HEX_TO_U8VEC4(0xa1814590),
+	HEX_TO_U8VEC4(0x9e7e4496), HEX_TO_U8VEC4(0xa6844887), HEX_TO_U8VEC4(0xa9864884),
+	HEX_TO_U8VEC4(0xad8a4a7c),
+};
+#undef HEX_TO_U8VEC4
+
+constexpr float PongStyle::wall_radius;
+constexpr float PongStyle::shadow_offset;
+constexpr float PongStyle::padding;
+constexpr float PongStyle::score_radius;
+
+std::vector< DrawRects::Rect > PongStyle::court_walls(glm::vec2 const &court_radius) {
+	std::vector< DrawRects::Rect > walls;
+	walls.reserve(2 * 4);
+	for (uint32_t pass = 0; pass < 2; ++pass) {
+		glm::vec2 s = (pass == 0 ? glm::vec2(0.0f,-shadow_offset) : glm::vec2(0.0f));
+		glm::u8vec4 color = (pass == 0 ? shadow_color : fg_color);
+		walls.emplace_back(glm::vec2(-court_radius.x-wall_radius, 0.0f)+s, glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), color);
+		walls.emplace_back(glm::vec2( court_radius.x+wall_radius, 0.0f)+s, glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), color);
+		walls.emplace_back(glm::vec2( 0.0f,-court_radius.y-wall_radius)+s, glm::vec2(court_radius.x, wall_radius), color);
+		walls.emplace_back(glm::vec2( 0.0f, court_radius.y+wall_radius)+s, glm::vec2(court_radius.x, wall_radius), color);
+	}
+	return walls;
+}
+
+glm::vec2 PongStyle::score_pip(glm::vec2 const &court_radius, bool left, uint32_t i) {
+	float x = court_radius.x - (2.0f + 3.0f * i) * score_radius;
+	return glm::vec2(left ? -x : x, court_radius.y + 2.0f * wall_radius + 2.0f * score_radius);
+}
+
+glm::mat4 PongStyle::court_to_clip(glm::vec2 const &court_radius, glm::uvec2 const &drawable_size, glm::mat3x2 *clip_to_court) {
+	//compute area that should be visible:
+	glm::vec2 scene_min = glm::vec2(
+		-court_radius.x - 2.0f * wall_radius - padding,
+		-court_radius.y - 2.0f * wall_radius - padding
+	);
+	glm::vec2 scene_max = glm::vec2(
+		court_radius.x + 2.0f * wall_radius + padding,
+		court_radius.y + 2.0f * wall_radius + 3.0f * score_radius + padding
+	);
+
+	//compute window aspect ratio:
+	float aspect = drawable_size.x / float(drawable_size.y);
+	//we'll scale the x coordinate by 1.0 / aspect to make sure things stay square.
+
+	//compute scale factor for court given that...
+	float scale = std::min(
+		(2.0f * aspect) / (scene_max.x - scene_min.x), //... x must fit in [-aspect,aspect] ...
+		(2.0f) / (scene_max.y - scene_min.y) //... y must fit in [-1,1].
+	);
+
+	glm::vec2 center = 0.5f * (scene_max + scene_min);
+
+	//also build the matrix that takes clip coordinates to court coordinates:
+	if (clip_to_court) {
+		*clip_to_court = glm::mat3x2(
+			glm::vec2(aspect / scale, 0.0f),
+			glm::vec2(0.0f, 1.0f / scale),
+			glm::vec2(center.x, center.y)
+		);
+	}
+
+	//build matrix that scales and translates appropriately:
+	//NOTE: glm matrices are specified in *Column-Major* order,
+	// so each line below is specifying a *column* of the matrix(!)
+	return glm::mat4(
+		glm::vec4(scale / aspect, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, scale, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+		glm::vec4(-center.x * (scale / aspect), -center.y * scale, 0.0f, 1.0f)
+	);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "DrawRects.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/*
+ * PongStyle is the look shared by PongMode and MultiBallMode: colors, wall and
+ *  score sizes, the static wall rectangles, and the court-to-window transform.
+ */
+
+struct PongStyle {
+	//some nice colors from the course web page:
+	static glm::u8vec4 const bg_color;
+	static glm::u8vec4 const fg_color;
+	static glm::u8vec4 const shadow_color;
+	static std::vector< glm::u8vec4 > const rainbow_colors; //ball trail, newest to oldest
+
+	//other useful drawing constants:
+	static constexpr float wall_radius = 0.05f;
+	static constexpr float shadow_offset = 0.07f; //(shadows are drawn this far below what casts them)
+	static constexpr float padding = 0.14f; //padding between outside of walls and edge of window
+	static constexpr float score_radius = 0.1f; //(scores are drawn as square pips)
+
+	//the four wall shadows, then the four walls (for DrawRects::set_static):
+	static std::vector< DrawRects::Rect > court_walls(glm::vec2 const &court_radius);
+
+	//center of score pip 'i' of the left (or right) player:
+	static glm::vec2 score_pip(glm::vec2 const &court_radius, bool left, uint32_t i);
+
+	//matrix that fits the court, walls, and scores into a drawable of the given size;
+	// also computes the matrix that maps clip coordinates back to court coordinates (for mouse handling):
+	static glm::mat4 court_to_clip(glm::vec2 const &court_radius, glm::uvec2 const &drawable_size, glm::mat3x2 *clip_to_court);
+};
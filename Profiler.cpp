@@ -0,0 +1,139 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+thread_local ProfileBuffer *profile_thread_buffer = nullptr;
+
+//a (tick, nanosecond) pair from program start, for converting ticks to time:
+static uint64_t steady_ns() {
+	return uint64_t(std::chrono::duration_cast< std::chrono::nanoseconds >(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+static uint64_t const start_ticks = profile_now();
+static uint64_t const start_ns = steady_ns();
+
+//every thread's buffer, in order of registration:
+// (buffers are never freed, so zones from threads that have exited still show up in dumps)
+static std::mutex &registry_mutex() {
+	static std::mutex mutex;
+	return mutex;
+}
+static std::vector< ProfileBuffer * > &registry() {
+	static std::vector< ProfileBuffer * > buffers;
+	return buffers;
+}
+
+ProfileBuffer *profile_register_thread() {
+	ProfileBuffer *buffer = new ProfileBuffer;
+	{
+		std::lock_guard< std::mutex > lock(registry_mutex());
+		buffer->thread = uint32_t(registry().size());
+		registry().emplace_back(buffer);
+	}
+	profile_thread_buffer = buffer;
+	return buffer;
+}
+
+void profile_thread_name(char const *name) {
+	ProfileBuffer *buffer = profile_thread_buffer;
+	if (!buffer) buffer = profile_register_thread();
+	buffer->name = name;
+}
+
+//write 'str' as a JSON string:
+static void write_json_string(std::ostream &out, char const *str) {
+	out << '"';
+	for (char const *c = str; *c; ++c) {
+		if (*c == '"' || *c == '\\') out << '\\' << *c;
+		else if (uint8_t(*c) < 0x20) out << ' ';
+		else out << *c;
+	}
+	out << '"';
+}
+
+void profile_dump(std::string const &filename) {
+	struct Zone {
+		ProfileBuffer::Event event;
+		uint32_t thread;
+	};
+	std::vector< Zone > zones;
+	std::vector< std::pair< uint32_t, char const * > > thread_names;
+
+	{ //copy events out of the buffers:
+		std::lock_guard< std::mutex > lock(registry_mutex());
+		for (ProfileBuffer *buffer : registry()) {
+			uint64_t head = buffer->head.load(std::memory_order_acquire);
+			uint64_t first = (head > ProfileBuffer::Capacity ? head - ProfileBuffer::Capacity : 0);
+			size_t start = zones.size();
+			for (uint64_t i = first; i < head; ++i) {
+				zones.emplace_back(Zone{ buffer->events[i & (ProfileBuffer::Capacity - 1)], buffer->thread });
+			}
+			//the owning thread may have kept recording (over the oldest events) while they were copied,
+			// so drop any copies that could have been overwritten:
+			// (the writer fills slot 'after' -- which held event 'after - Capacity' -- before publishing 'after + 1',
+			//  so events first .. after - Capacity, inclusive, may be torn)
+			std::atomic_thread_fence(std::memory_order_acquire); //(keeps the copies above from moving past the load below)
+			uint64_t after = buffer->head.load(std::memory_order_relaxed);
+			if (after + 1 > first + ProfileBuffer::Capacity) {
+				uint64_t overwritten = std::min(after + 1 - (first + ProfileBuffer::Capacity), head - first);
+				zones.erase(zones.begin() + start, zones.begin() + start + size_t(overwritten));
+			}
+			thread_names.emplace_back(buffer->thread, buffer->name);
+		}
+	}
+
+	uint64_t epoch = ~uint64_t(0);
+	for (auto const &zone : zones) {
+		epoch = std::min(epoch, zone.event.begin);
+	}
+
+	//microseconds per tick:
+	double us_per_tick = 1.0e-3;
+	#ifdef PROFILE_TSC
+	//(measure the tick rate against the steady clock, over at least 10ms)
+	uint64_t ticks, ns;
+	do {
+		ticks = profile_now();
+		ns = steady_ns();
+	} while (ns - start_ns < 10000000);
+	us_per_tick = ((ns - start_ns) * 1.0e-3) / double(ticks - start_ticks);
+	#endif
+
+	std::ofstream out(filename, std::ios::binary);
+	if (!out) {
+		throw std::runtime_error("Failed to open '" + filename + "' for writing.");
+	}
+	out.setf(std::ios::fixed);
+	out.precision(3);
+
+	out << "{\"traceEvents\":[\n";
+	bool first = true;
+	for (auto const &thread_name : thread_names) {
+		if (!thread_name.second) continue;
+		if (!first) out << ",\n";
+		first = false;
+		out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << thread_name.first << ",\"args\":{\"name\":";
+		write_json_string(out, thread_name.second);
+		out << "}}";
+	}
+	for (auto const &zone : zones) {
+		if (!first) out << ",\n";
+		first = false;
+		//(complete events, with times in microseconds)
+		out << "{\"ph\":\"X\",\"name\":";
+		write_json_string(out, zone.event.name);
+		out << ",\"pid\":1,\"tid\":" << zone.thread
+			<< ",\"ts\":" << (zone.event.begin - epoch) * us_per_tick
+			<< ",\"dur\":" << (zone.event.end - zone.event.begin) * us_per_tick << "}";
+	}
+	out << "\n]}\n";
+
+	if (!out) {
+		throw std::runtime_error("Failed to write '" + filename + "'.");
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <string>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+/*
+ * A small instrumenting profiler:
+ *
+ *   void Thing::update() {
+ *       PROFILE_ZONE("Thing::update");
+ *       ...
+ *   }
+ *
+ * records when the enclosing scope began and ended. Each thread records into its
+ *  own ring buffer (no locks, no allocation after the thread's first zone), which
+ *  holds the most recent ProfileBuffer::Capacity zones.
+ *
+ * profile_dump() writes everything recorded so far in Chrome's trace event
+ *  format; open it in chrome://tracing or https://ui.perfetto.dev.
+ */
+
+//'name' must outlive the profiler (use string literals):
+#define PROFILE_ZONE(NAME) ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(NAME)
+#define PROFILE_CONCAT2(A, B) A ## B
+#define PROFILE_CONCAT(A, B) PROFILE_CONCAT2(A, B)
+
+//name the calling thread in dumps:
+void profile_thread_name(char const *name);
+
+//write all recorded zones to 'filename' as Chrome trace event JSON (callable from any thread):
+// (throws on error)
+void profile_dump(std::string const &filename);
+
+//----- internals -----
+
+//timestamps are in cpu ticks where that's cheap (x86's time stamp counter), nanoseconds otherwise;
+// profile_dump() converts them to real time.
+#if defined(__x86_64__) || defined(_M_X64)
+#define PROFILE_TSC 1
+inline uint64_t profile_now() {
+	return __rdtsc();
+}
+#else
+inline uint64_t profile_now() {
+	return uint64_t(std::chrono::duration_cast< std::chrono::nanoseconds >(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+#endif
+
+struct ProfileBuffer {
+	static constexpr uint64_t Capacity = 1 << 16;
+	struct Event {
+		char const *name;
+		uint64_t begin, end; //from profile_now()
+	};
+	//only the owning thread writes events; 'head' is published with release so dumps can read behind it:
+	std::atomic< uint64_t > head{0}; //total events ever recorded
+	Event events[Capacity];
+
+	uint32_t thread = 0; //index, in order of first zone
+	char const *name = nullptr;
+};
+
+ProfileBuffer *profile_register_thread(); //make a buffer for the calling thread
+extern thread_local ProfileBuffer *profile_thread_buffer;
+
+inline void profile_record(char const *name, uint64_t begin, uint64_t end) {
+	ProfileBuffer *buffer = profile_thread_buffer;
+	if (!buffer) buffer = profile_register_thread();
+	uint64_t head = buffer->head.load(std::memory_order_relaxed);
+	ProfileBuffer::Event &event = buffer->events[head & (ProfileBuffer::Capacity - 1)];
+	event.name = name;
+	event.begin = begin;
+	event.end = end;
+	buffer->head.store(head + 1, std::memory_order_release);
+}
+
+struct ProfileZone {
+	ProfileZone(char const *name_) : name(name_), begin(profile_now()) { }
+	~ProfileZone() { profile_record(name, begin, profile_now()); }
+	char const *name;
+	uint64_t begin;
+};
@@ -0,0 +1,49 @@
+#include "RectProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+#include "GLState.hpp"
+
+RectProgram::RectProgram() {
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"in vec2 Corner;\n"
+		"in vec2 Center;\n"
+		"in vec2 Radius;\n"
+		"in vec4 Color;\n"
+		"out vec4 color;\n"
+		"void main() {\n"
+		"	gl_Position = OBJECT_TO_CLIP * vec4(Center + Corner * Radius, 0.0, 1.0);\n"
+		"	color = Color;\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = color;\n"
+		"}\n"
+	);
+
+	gl_label(GL_PROGRAM, program, "RectProgram");
+
+	//look up the locations of vertex attributes:
+	Corner_vec2 = glGetAttribLocation(program, "Corner");
+	Center_vec2 = glGetAttribLocation(program, "Center");
+	Radius_vec2 = glGetAttribLocation(program, "Radius");
+	Color_vec4 = glGetAttribLocation(program, "Color");
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+RectProgram::~RectProgram() {
+	glDeleteProgram(program);
+	gl_state.deleted_program(program);
+	program = 0;
+}
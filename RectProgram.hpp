@@ -0,0 +1,23 @@
+#pragma once
+
+#include "GL.hpp"
+
+//Shader program that draws solid-colored, axis-aligned rectangles, one per instance:
+// (each instance expands a shared unit quad to its own center, radius, and color)
+struct RectProgram {
+	RectProgram();
+	~RectProgram();
+
+	GLuint program = 0;
+
+	//Attribute (per-vertex variable) locations:
+	GLuint Corner_vec2 = -1U; //unit quad corner, in [-1,1]^2
+
+	//Attribute (per-instance variable) locations:
+	GLuint Center_vec2 = -1U;
+	GLuint Radius_vec2 = -1U;
+	GLuint Color_vec4 = -1U;
+
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+};
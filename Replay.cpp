@@ -0,0 +1,146 @@
+#include "Replay.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+//File layout:
+// "pongrpl0"                    magic (8 bytes)
+// varint seed, varint stream
+// varint step count
+// per step: zigzag varint (left_paddle_y bits - previous left_paddle_y bits)
+//           zigzag varint (elapsed bits - previous elapsed bits)
+//           (both "previous" values start at zero)
+// 8 bytes final checksum (little-endian)
+
+static char const Magic[8] = { 'p','o','n','g','r','p','l','0' };
+
+uint64_t Replay::checksum(PongGame const &game) {
+	uint64_t ret = 0xcbf29ce484222325ull;
+	auto add = [&ret](void const *data, size_t size) {
+		for (size_t i = 0; i < size; ++i) {
+			ret = (ret ^ reinterpret_cast< uint8_t const * >(data)[i]) * 0x100000001b3ull;
+		}
+	};
+	add(&game.left_score, sizeof(game.left_score));
+	add(&game.right_score, sizeof(game.right_score));
+	add(&game.time, sizeof(game.time));
+	add(&game.ball, sizeof(game.ball));
+	add(&game.ball_velocity, sizeof(game.ball_velocity));
+	add(&game.left_paddle, sizeof(game.left_paddle));
+	add(&game.right_paddle, sizeof(game.right_paddle));
+	return ret;
+}
+
+static uint32_t float_bits(float f) {
+	uint32_t bits;
+	std::memcpy(&bits, &f, 4);
+	return bits;
+}
+
+static float bits_float(uint32_t bits) {
+	float f;
+	std::memcpy(&f, &bits, 4);
+	return f;
+}
+
+void save_replay(std::string filename, Replay const &replay) {
+	std::vector< uint8_t > data;
+	data.reserve(sizeof(Magic) + 30 + replay.steps.size() * 3);
+
+	auto varint = [&data](uint64_t val) {
+		while (val >= 0x80) {
+			data.emplace_back(uint8_t(val | 0x80));
+			val >>= 7;
+		}
+		data.emplace_back(uint8_t(val));
+	};
+	//change from 'prev' to 'bits', mapped so that small changes of either sign are small numbers:
+	auto zigzag_delta = [&varint](uint32_t bits, uint32_t *prev) {
+		int32_t delta = int32_t(bits - *prev);
+		*prev = bits;
+		varint((uint32_t(delta) << 1) ^ uint32_t(delta >> 31));
+	};
+
+	data.insert(data.end(), Magic, Magic + sizeof(Magic));
+	varint(replay.seed);
+	varint(replay.stream);
+	varint(replay.steps.size());
+
+	uint32_t prev_y = 0;
+	uint32_t prev_elapsed = 0;
+	for (auto const &step : replay.steps) {
+		zigzag_delta(float_bits(step.left_paddle_y), &prev_y);
+		zigzag_delta(float_bits(step.elapsed), &prev_elapsed);
+	}
+
+	for (uint32_t i = 0; i < 8; ++i) {
+		data.emplace_back(uint8_t(replay.final_checksum >> (8 * i)));
+	}
+
+	std::ofstream file(filename.c_str(), std::ios::binary);
+	if (!file.write(reinterpret_cast< char const * >(data.data()), data.size())) {
+		throw std::runtime_error("Failed to write replay to '" + filename + "'.");
+	}
+}
+
+void load_replay(std::string filename, Replay *replay) {
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open replay file '" + filename + "'.");
+	}
+	std::vector< uint8_t > data((std::istreambuf_iterator< char >(file)), std::istreambuf_iterator< char >());
+
+	uint8_t const *at = data.data();
+	uint8_t const *end = data.data() + data.size();
+
+	auto bad = [&filename](char const *what) {
+		throw std::runtime_error("Replay file '" + filename + "' is invalid (" + what + ").");
+	};
+	auto varint = [&]() {
+		uint64_t val = 0;
+		for (uint32_t shift = 0; shift < 64; shift += 7) {
+			if (at == end) bad("truncated");
+			uint8_t byte = *(at++);
+			val |= uint64_t(byte & 0x7f) << shift;
+			if (!(byte & 0x80)) return val;
+		}
+		bad("varint too long");
+		return val;
+	};
+	auto zigzag_delta = [&](uint32_t *prev) {
+		uint64_t z = varint();
+		if (z > 0xffffffffull) bad("delta too large");
+		uint32_t delta = uint32_t(z >> 1) ^ (0u - uint32_t(z & 1));
+		*prev += delta;
+		return *prev;
+	};
+
+	if (size_t(end - at) < sizeof(Magic) || std::memcmp(at, Magic, sizeof(Magic)) != 0) bad("wrong magic number");
+	at += sizeof(Magic);
+
+	Replay ret;
+	ret.seed = varint();
+	ret.stream = varint();
+	uint64_t count = varint();
+	//every step takes at least two bytes, so this catches nonsense counts before allocating:
+	if (count > uint64_t(end - at) / 2) bad("step count larger than file");
+	ret.steps.reserve(size_t(count));
+
+	uint32_t prev_y = 0;
+	uint32_t prev_elapsed = 0;
+	for (uint64_t i = 0; i < count; ++i) {
+		Replay::Step step;
+		step.left_paddle_y = bits_float(zigzag_delta(&prev_y));
+		step.elapsed = bits_float(zigzag_delta(&prev_elapsed));
+		ret.steps.emplace_back(step);
+	}
+
+	if (end - at != 8) bad("wrong size");
+	for (uint32_t i = 0; i < 8; ++i) {
+		ret.final_checksum |= uint64_t(at[i]) << (8 * i);
+	}
+
+	*replay = std::move(ret);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "PongGame.hpp"
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * A Replay is the complete input to a PongGame match -- the rng seed and,
+ *  for every update, the (mouse-controlled) left paddle position and the
+ *  elapsed time -- so the match can be run again exactly, as often as needed.
+ *
+ * Recording assumes a default-constructed PongGame (left paddle played by the
+ *  mouse); PongMode records with '--record' and plays back with '--replay',
+ *  and the 'pong-replay' tool (play_replay.cpp) re-runs replays at full speed.
+ *
+ * Files store each step as the change in the bit patterns of the two floats
+ *  (zigzag + varint encoded), so the usual constant elapsed time costs one
+ *  byte and small paddle movements cost two or three.
+ */
+
+struct Replay {
+	uint64_t seed = 0; //match is played with CounterRNG(seed, stream)
+	uint64_t stream = 0;
+
+	struct Step {
+		float left_paddle_y; //PongGame::left_paddle.y before the update
+		float elapsed; //argument to PongGame::update
+	};
+	std::vector< Step > steps;
+
+	//checksum of the match after the last step (see checksum() below), or zero if not known:
+	uint64_t final_checksum = 0;
+
+	//----- recording -----
+
+	//set up 'game' to be recorded (or re-run) from its first step:
+	void start(PongGame *game) const {
+		*game = PongGame();
+		game->rng = CounterRNG(seed, stream);
+	}
+
+	//record the input for one update of 'game' (call just before game->update(elapsed)):
+	void record(PongGame const &game, float elapsed) {
+		steps.emplace_back(Step{ game.left_paddle.y, elapsed });
+	}
+
+	//----- playing back -----
+
+	//run recorded update number 'step' on 'game':
+	void play(uint32_t step, PongGame *game) const {
+		game->left_paddle.y = steps[step].left_paddle_y;
+		game->update(steps[step].elapsed);
+	}
+
+	//FNV-1a over the parts of a match that any divergence would quickly show up in:
+	// (scores, time, and the ball and paddle positions and velocity)
+	static uint64_t checksum(PongGame const &game);
+};
+
+//NOTE: load_replay will throw on error
+void load_replay(std::string filename, Replay *replay);
+void save_replay(std::string filename, Replay const &replay);
@@ -0,0 +1,149 @@
+#include "StreamingBuffer.hpp"
+
+#include "gl_extensions.hpp"
+#include "gl_errors.hpp"
+#include "GLState.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+StreamingBuffer::StreamingBuffer(GLsizeiptr frame_size_) {
+	persistent = gl_extensions.ARB_buffer_storage;
+	allocate(frame_size_);
+}
+
+StreamingBuffer::~StreamingBuffer() {
+	release();
+}
+
+void StreamingBuffer::release() {
+	for (auto &fence : fences) {
+		if (fence) {
+			glDeleteSync(fence);
+			fence = 0;
+		}
+	}
+	if (buffer) {
+		if (persistent_data) {
+			gl_state.bind_buffer(GL_ARRAY_BUFFER, buffer);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			persistent_data = nullptr;
+		}
+		glDeleteBuffers(1, &buffer);
+		gl_state.deleted_buffer(buffer);
+		buffer = 0;
+	}
+}
+
+void StreamingBuffer::allocate(GLsizeiptr frame_size_) {
+	if (buffer) generation += 1;
+	//NOTE: the old buffer may still be in use by the GPU; OpenGL keeps its storage alive until it isn't.
+	release();
+
+	frame_size = frame_size_;
+
+	glGenBuffers(1, &buffer);
+	gl_state.bind_buffer(GL_ARRAY_BUFFER, buffer);
+	gl_label(GL_BUFFER, buffer, "StreamingBuffer");
+	if (persistent) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		gl_extensions.BufferStorage(GL_ARRAY_BUFFER, Frames * frame_size, nullptr, flags);
+		persistent_data = reinterpret_cast< uint8_t * >(glMapBufferRange(GL_ARRAY_BUFFER, 0, Frames * frame_size, flags));
+		if (!persistent_data) {
+			throw std::runtime_error("StreamingBuffer: failed to map buffer persistently.");
+		}
+	} else {
+		glBufferData(GL_ARRAY_BUFFER, Frames * frame_size, nullptr, GL_STREAM_DRAW);
+	}
+
+	GL_ERRORS();
+
+	//fresh buffer, so nothing is in flight:
+	frame = 0;
+	cursor = 0;
+	waited = true;
+}
+
+void *StreamingBuffer::map(GLsizeiptr size, GLsizeiptr alignment, GLintptr *offset) {
+	assert(!mapped);
+	assert(alignment > 0);
+	assert(offset);
+	if (size < 1) size = 1; //(zero-length maps are an error)
+
+	//offsets are aligned relative to the start of the buffer (so, e.g., they can be turned into vertex indices):
+	GLintptr region = GLintptr(frame) * frame_size;
+	GLintptr start = (region + cursor + alignment - 1) / alignment * alignment;
+
+	if (start + size > region + frame_size) {
+		//out of room this frame: replace the ring with one large enough
+		GLsizeiptr new_size = frame_size;
+		while (new_size < size + alignment) new_size *= 2;
+		allocate(new_size);
+		region = 0;
+		start = 0;
+	}
+
+	if (!waited) {
+		//make sure the GPU is done with the data written to this region Frames frames ago:
+		if (fences[frame]) {
+			GLenum result = glClientWaitSync(fences[frame], 0, 0);
+			if (result == GL_TIMEOUT_EXPIRED) {
+				stalls += 1;
+				do {
+					result = glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+				} while (result == GL_TIMEOUT_EXPIRED);
+			}
+			if (result == GL_WAIT_FAILED) {
+				std::cerr << "WARNING: StreamingBuffer: waiting on fence failed." << std::endl;
+			}
+			glDeleteSync(fences[frame]);
+			fences[frame] = 0;
+		}
+		waited = true;
+	}
+
+	cursor = (start - region) + size;
+	*offset = start;
+	mapped = true;
+
+	if (persistent) {
+		return persistent_data + start;
+	}
+
+	//the fences already guarantee the GPU isn't using this range, so skip the driver's own synchronization:
+	gl_state.bind_buffer(GL_ARRAY_BUFFER, buffer);
+	void *data = glMapBufferRange(GL_ARRAY_BUFFER, start, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	if (!data) {
+		mapped = false;
+		throw std::runtime_error("StreamingBuffer: failed to map buffer range.");
+	}
+	return data;
+}
+
+void StreamingBuffer::unmap() {
+	assert(mapped);
+	mapped = false;
+
+	//(persistent mappings are coherent, so there is nothing to do)
+	if (persistent) return;
+
+	gl_state.bind_buffer(GL_ARRAY_BUFFER, buffer);
+	if (glUnmapBuffer(GL_ARRAY_BUFFER) != GL_TRUE) {
+		std::cerr << "WARNING: StreamingBuffer: buffer contents were lost while mapped." << std::endl;
+	}
+}
+
+void StreamingBuffer::end_frame() {
+	assert(!mapped);
+
+	//fence this region only if it was used:
+	if (cursor > 0) {
+		assert(fences[frame] == 0);
+		fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	frame = (frame + 1) % Frames;
+	cursor = 0;
+	waited = false;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <stdint.h>
+
+/*
+ * StreamingBuffer is a vertex buffer for data that is rewritten every frame.
+ *
+ * It is a ring of 'Frames' equal regions; each frame writes into the next region,
+ *  and a fence placed after that frame's draws tells when the GPU is done with
+ *  it. So writing never has to wait for (or make the driver copy around) data
+ *  that is still being drawn, and nothing is allocated once the ring is big enough.
+ *
+ * With ARB_buffer_storage (see gl_extensions.hpp), the whole ring is mapped once,
+ *  persistently; otherwise each range is mapped with GL_MAP_UNSYNCHRONIZED_BIT.
+ *
+ * Usage, each frame:
+ *   GLintptr offset;
+ *   Vertex *vertices = reinterpret_cast< Vertex * >(stream.map(count * sizeof(Vertex), sizeof(Vertex), &offset));
+ *   ... write up to 'count' vertices ...
+ *   stream.unmap();
+ *   ... draw from stream.buffer starting at offset ...
+ *   stream.end_frame();
+ */
+
+struct StreamingBuffer {
+	static constexpr uint32_t Frames = 3;
+
+	//'frame_size' is the starting size of each region (it grows as needed):
+	StreamingBuffer(GLsizeiptr frame_size = 1 << 16);
+	~StreamingBuffer();
+
+	StreamingBuffer(StreamingBuffer const &) = delete;
+	StreamingBuffer &operator=(StreamingBuffer const &) = delete;
+
+	//reserve 'size' bytes in this frame's region, starting at a multiple of 'alignment';
+	// returns a pointer for writing them and sets *offset to their offset in 'buffer'.
+	//NOTE: if this frame's region is too small, the buffer is replaced with a larger one
+	// (so 'buffer' changes, and ranges mapped earlier in the frame must not be drawn after that).
+	void *map(GLsizeiptr size, GLsizeiptr alignment, GLintptr *offset);
+
+	//finish writing the most recently mapped range (call before drawing from it):
+	void unmap();
+
+	//call after the frame's draws have been issued, to fence this region and move on to the next:
+	void end_frame();
+
+	//the buffer object (bind as GL_ARRAY_BUFFER to draw from it):
+	GLuint buffer = 0;
+
+	//number of times the ring has been replaced with a larger one:
+	uint32_t generation = 0;
+
+	//number of times map() had to wait for the GPU to finish with a region:
+	uint32_t stalls = 0;
+
+	//----- internals -----
+
+	bool persistent = false; //(using ARB_buffer_storage)
+	GLsizeiptr frame_size = 0;
+	uint8_t *persistent_data = nullptr; //whole ring, if mapped persistently
+
+	uint32_t frame = 0; //region being written this frame
+	GLsizeiptr cursor = 0; //bytes used in that region
+	bool waited = false; //whether this frame's region is known to be free
+	bool mapped = false;
+	GLsync fences[Frames] = { };
+
+	void allocate(GLsizeiptr frame_size); //(re)create 'buffer'
+	void release();
+};
@@ -0,0 +1,387 @@
+#include "bake_texture.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BAKE_TEXTURE_X86
+#include <emmintrin.h>
+#endif
+
+namespace {
+	const uint32_t Version = 1;
+	const size_t HeaderSize = 6 * 4;
+	const size_t LevelSize = 2 * 4 + 2 * 8;
+	const size_t Alignment = 16;
+
+	void put_u32(uint8_t *at, uint32_t v) {
+		for (uint32_t i = 0; i < 4; ++i) at[i] = uint8_t(v >> (8 * i));
+	}
+	void put_u64(uint8_t *at, uint64_t v) {
+		for (uint32_t i = 0; i < 8; ++i) at[i] = uint8_t(v >> (8 * i));
+	}
+	uint32_t get_u32(uint8_t const *at) {
+		uint32_t v = 0;
+		for (uint32_t i = 0; i < 4; ++i) v |= uint32_t(at[i]) << (8 * i);
+		return v;
+	}
+	uint64_t get_u64(uint8_t const *at) {
+		uint64_t v = 0;
+		for (uint32_t i = 0; i < 8; ++i) v |= uint64_t(at[i]) << (8 * i);
+		return v;
+	}
+
+	size_t level_bytes(BakedTextureFormat format, glm::uvec2 size) {
+		if (format == BakedRGBA8) return size_t(size.x) * size.y * 4;
+		else return compressed_size(format, size);
+	}
+}
+
+//------------------------------------------------------------------
+//mip chain:
+
+void downsample(glm::uvec2 size, glm::u8vec4 const *from, glm::u8vec4 *to) {
+	glm::uvec2 to_size = mip_size(size);
+	for (uint32_t y = 0; y < to_size.y; ++y) {
+		//(a dimension of 1 just repeats its only row or column)
+		glm::u8vec4 const *row0 = from + size_t(std::min(2 * y, size.y - 1)) * size.x;
+		glm::u8vec4 const *row1 = from + size_t(std::min(2 * y + 1, size.y - 1)) * size.x;
+		glm::u8vec4 *out = to + size_t(y) * to_size.x;
+		uint32_t x = 0;
+		#ifdef BAKE_TEXTURE_X86
+		if (size.x >= 2) {
+			//two output pixels (four input columns) per iteration:
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i two = _mm_set1_epi16(2);
+			for (; x + 2 <= to_size.x; x += 2) {
+				__m128i a = _mm_loadu_si128(reinterpret_cast< __m128i const * >(row0 + 2 * x));
+				__m128i b = _mm_loadu_si128(reinterpret_cast< __m128i const * >(row1 + 2 * x));
+				//add rows, as 16-bit channels (pixels 0,1 in 'lo', 2,3 in 'hi'):
+				__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+				__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+				//add neighboring columns:
+				lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+				hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+				//round, divide by four, and pack back to bytes:
+				__m128i sum = _mm_unpacklo_epi64(lo, hi);
+				__m128i avg = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+				_mm_storel_epi64(reinterpret_cast< __m128i * >(out + x), _mm_packus_epi16(avg, zero));
+			}
+		}
+		#endif
+		for (; x < to_size.x; ++x) {
+			uint32_t x0 = std::min(2 * x, size.x - 1);
+			uint32_t x1 = std::min(2 * x + 1, size.x - 1);
+			for (uint32_t c = 0; c < 4; ++c) {
+				out[x][c] = uint8_t((row0[x0][c] + row0[x1][c] + row1[x0][c] + row1[x1][c] + 2) / 4);
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------
+//BC1 / BC3 block compression:
+// colors: endpoints are the pixels furthest apart along the block's principal axis
+//  (as in stb_dxt), then each pixel picks the closest of the four palette colors.
+// alpha (BC3): endpoints are the min and max alpha, with eight interpolated levels.
+
+namespace {
+	struct RGB {
+		int r, g, b;
+	};
+	uint16_t to_565(glm::u8vec4 c) {
+		return uint16_t(((c.r * 31 + 127) / 255) << 11 | ((c.g * 63 + 127) / 255) << 5 | ((c.b * 31 + 127) / 255));
+	}
+	RGB from_565(uint16_t c) {
+		int r = (c >> 11) & 0x1f, g = (c >> 5) & 0x3f, b = c & 0x1f;
+		return RGB{ (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+	}
+	//(2a + b) / 3 and friends:
+	RGB mix(RGB a, int wa, RGB b, int wb) {
+		int w = wa + wb;
+		return RGB{ (wa * a.r + wb * b.r) / w, (wa * a.g + wb * b.g) / w, (wa * a.b + wb * b.b) / w };
+	}
+
+	void compress_color_block(glm::u8vec4 const block[16], uint8_t out[8]) {
+		//principal axis of the colors, by power iteration on their covariance:
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (uint32_t i = 0; i < 16; ++i) {
+			for (uint32_t c = 0; c < 3; ++c) mean[c] += block[i][c] / 16.0f;
+		}
+		float cov[3][3] = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+		for (uint32_t i = 0; i < 16; ++i) {
+			float d[3];
+			for (uint32_t c = 0; c < 3; ++c) {
+				d[c] = block[i][c] - mean[c];
+			}
+			for (uint32_t r = 0; r < 3; ++r) {
+				for (uint32_t c = 0; c < 3; ++c) cov[r][c] += d[r] * d[c];
+			}
+		}
+		//(start from the covariance row of the channel that varies most -- unlike, e.g., the bounding box diagonal, it can't
+		// be perpendicular to the principal axis, which matters for blocks where channels are anti-correlated)
+		uint32_t widest = 0;
+		for (uint32_t c = 1; c < 3; ++c) {
+			if (cov[c][c] > cov[widest][widest]) widest = c;
+		}
+		float axis[3] = { cov[widest][0], cov[widest][1], cov[widest][2] };
+		for (uint32_t iter = 0; iter < 4; ++iter) {
+			float next[3];
+			for (uint32_t r = 0; r < 3; ++r) {
+				next[r] = cov[r][0] * axis[0] + cov[r][1] * axis[1] + cov[r][2] * axis[2];
+			}
+			float length = std::max(std::abs(next[0]), std::max(std::abs(next[1]), std::abs(next[2])));
+			if (length < 1e-6f) break; //(solid block: any axis will do)
+			for (uint32_t c = 0; c < 3; ++c) axis[c] = next[c] / length;
+		}
+
+		uint32_t min_i = 0, max_i = 0;
+		float min_d = 1e30f, max_d = -1e30f;
+		for (uint32_t i = 0; i < 16; ++i) {
+			float d = block[i].r * axis[0] + block[i].g * axis[1] + block[i].b * axis[2];
+			if (d < min_d) { min_d = d; min_i = i; }
+			if (d > max_d) { max_d = d; max_i = i; }
+		}
+
+		uint16_t c0 = to_565(block[max_i]);
+		uint16_t c1 = to_565(block[min_i]);
+		if (c0 < c1) std::swap(c0, c1);
+		uint32_t indices = 0;
+		if (c0 != c1) {
+			//(c0 > c1 selects four-color mode)
+			RGB palette[4];
+			palette[0] = from_565(c0);
+			palette[1] = from_565(c1);
+			palette[2] = mix(palette[0], 2, palette[1], 1);
+			palette[3] = mix(palette[0], 1, palette[1], 2);
+			for (uint32_t i = 0; i < 16; ++i) {
+				uint32_t best = 0;
+				int best_distance = 0x7fffffff;
+				for (uint32_t p = 0; p < 4; ++p) {
+					int dr = block[i].r - palette[p].r, dg = block[i].g - palette[p].g, db = block[i].b - palette[p].b;
+					int distance = dr * dr + dg * dg + db * db;
+					if (distance < best_distance) {
+						best_distance = distance;
+						best = p;
+					}
+				}
+				indices |= best << (2 * i);
+			}
+		}
+		out[0] = uint8_t(c0); out[1] = uint8_t(c0 >> 8);
+		out[2] = uint8_t(c1); out[3] = uint8_t(c1 >> 8);
+		put_u32(out + 4, indices);
+	}
+
+	void compress_alpha_block(glm::u8vec4 const block[16], uint8_t out[8]) {
+		int a0 = 0, a1 = 255;
+		for (uint32_t i = 0; i < 16; ++i) {
+			a0 = std::max(a0, int(block[i].a));
+			a1 = std::min(a1, int(block[i].a));
+		}
+		uint64_t indices = 0;
+		if (a0 != a1) {
+			//(a0 > a1 selects eight-level mode)
+			int palette[8] = { a0, a1 };
+			for (int p = 1; p < 7; ++p) palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+			for (uint32_t i = 0; i < 16; ++i) {
+				uint64_t best = 0;
+				int best_distance = 256;
+				for (uint32_t p = 0; p < 8; ++p) {
+					int distance = std::abs(int(block[i].a) - palette[p]);
+					if (distance < best_distance) {
+						best_distance = distance;
+						best = p;
+					}
+				}
+				indices |= best << (3 * i);
+			}
+		}
+		out[0] = uint8_t(a0);
+		out[1] = uint8_t(a1);
+		for (uint32_t i = 0; i < 6; ++i) out[2 + i] = uint8_t(indices >> (8 * i));
+	}
+
+	void decompress_color_block(uint8_t const in[8], bool four_color_only, glm::u8vec4 block[16]) {
+		uint16_t c0 = uint16_t(in[0] | in[1] << 8);
+		uint16_t c1 = uint16_t(in[2] | in[3] << 8);
+		RGB palette[4];
+		palette[0] = from_565(c0);
+		palette[1] = from_565(c1);
+		bool transparent = false;
+		if (c0 > c1 || four_color_only) {
+			palette[2] = mix(palette[0], 2, palette[1], 1);
+			palette[3] = mix(palette[0], 1, palette[1], 2);
+		} else {
+			palette[2] = mix(palette[0], 1, palette[1], 1);
+			palette[3] = RGB{ 0, 0, 0 };
+			transparent = true;
+		}
+		uint32_t indices = get_u32(in + 4);
+		for (uint32_t i = 0; i < 16; ++i) {
+			uint32_t p = (indices >> (2 * i)) & 3;
+			block[i] = glm::u8vec4(palette[p].r, palette[p].g, palette[p].b, (transparent && p == 3 ? 0 : 0xff));
+		}
+	}
+
+	void decompress_alpha_block(uint8_t const in[8], glm::u8vec4 block[16]) {
+		int a0 = in[0], a1 = in[1];
+		int palette[8] = { a0, a1 };
+		if (a0 > a1) {
+			for (int p = 1; p < 7; ++p) palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+		} else {
+			for (int p = 1; p < 5; ++p) palette[p + 1] = ((5 - p) * a0 + p * a1) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+		uint64_t indices = 0;
+		for (uint32_t i = 0; i < 6; ++i) indices |= uint64_t(in[2 + i]) << (8 * i);
+		for (uint32_t i = 0; i < 16; ++i) {
+			block[i].a = uint8_t(palette[(indices >> (3 * i)) & 7]);
+		}
+	}
+}
+
+size_t compressed_size(BakedTextureFormat format, glm::uvec2 size) {
+	assert(format == BakedBC1 || format == BakedBC3);
+	size_t blocks = size_t((size.x + 3) / 4) * ((size.y + 3) / 4);
+	return blocks * (format == BakedBC1 ? 8 : 16);
+}
+
+void compress_blocks(BakedTextureFormat format, glm::uvec2 size, glm::u8vec4 const *data, uint8_t *blocks) {
+	assert(format == BakedBC1 || format == BakedBC3);
+	glm::u8vec4 block[16];
+	for (uint32_t by = 0; by < size.y; by += 4) {
+		for (uint32_t bx = 0; bx < size.x; bx += 4) {
+			//gather the block (repeating edge pixels of blocks that hang off the image):
+			for (uint32_t y = 0; y < 4; ++y) {
+				for (uint32_t x = 0; x < 4; ++x) {
+					block[y * 4 + x] = data[size_t(std::min(by + y, size.y - 1)) * size.x + std::min(bx + x, size.x - 1)];
+				}
+			}
+			if (format == BakedBC3) {
+				compress_alpha_block(block, blocks);
+				blocks += 8;
+			}
+			compress_color_block(block, blocks);
+			blocks += 8;
+		}
+	}
+}
+
+void decompress_blocks(BakedTextureFormat format, glm::uvec2 size, uint8_t const *blocks, glm::u8vec4 *data) {
+	assert(format == BakedBC1 || format == BakedBC3);
+	glm::u8vec4 block[16];
+	for (uint32_t by = 0; by < size.y; by += 4) {
+		for (uint32_t bx = 0; bx < size.x; bx += 4) {
+			if (format == BakedBC3) {
+				decompress_color_block(blocks + 8, true, block);
+				decompress_alpha_block(blocks, block);
+				blocks += 16;
+			} else {
+				decompress_color_block(blocks, false, block);
+				blocks += 8;
+			}
+			for (uint32_t y = 0; y < 4 && by + y < size.y; ++y) {
+				for (uint32_t x = 0; x < 4 && bx + x < size.x; ++x) {
+					data[size_t(by + y) * size.x + bx + x] = block[y * 4 + x];
+				}
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------
+//container:
+
+void bake_texture(glm::uvec2 size, glm::u8vec4 const *data, BakedTextureFormat format, bool mipmaps, std::vector< uint8_t > *baked) {
+	assert(baked);
+	if (size.x == 0 || size.y == 0) throw std::runtime_error("Can't bake an empty texture.");
+	if (format != BakedRGBA8 && format != BakedBC1 && format != BakedBC3) throw std::runtime_error("Unknown baked texture format.");
+
+	//level sizes and layout:
+	std::vector< glm::uvec2 > sizes(1, size);
+	while (mipmaps && (sizes.back().x > 1 || sizes.back().y > 1)) {
+		sizes.emplace_back(mip_size(sizes.back()));
+	}
+	std::vector< size_t > offsets;
+	size_t end = HeaderSize + LevelSize * sizes.size();
+	for (auto const &level : sizes) {
+		end = (end + Alignment - 1) / Alignment * Alignment;
+		offsets.emplace_back(end);
+		end += level_bytes(format, level);
+	}
+
+	baked->assign(end, 0);
+	uint8_t *out = baked->data();
+	std::memcpy(out, "btex", 4);
+	put_u32(out + 4, Version);
+	put_u32(out + 8, format);
+	put_u32(out + 12, size.x);
+	put_u32(out + 16, size.y);
+	put_u32(out + 20, uint32_t(sizes.size()));
+	for (uint32_t l = 0; l < sizes.size(); ++l) {
+		uint8_t *entry = out + HeaderSize + LevelSize * l;
+		put_u32(entry, sizes[l].x);
+		put_u32(entry + 4, sizes[l].y);
+		put_u64(entry + 8, offsets[l]);
+		put_u64(entry + 16, level_bytes(format, sizes[l]));
+	}
+
+	//each level is filtered from the one before it (so 'current' is the full-precision level being stored):
+	std::vector< glm::u8vec4 > current(data, data + size_t(size.x) * size.y);
+	std::vector< glm::u8vec4 > next;
+	for (uint32_t l = 0; l < sizes.size(); ++l) {
+		if (l > 0) {
+			next.resize(size_t(sizes[l].x) * sizes[l].y);
+			downsample(sizes[l - 1], current.data(), next.data());
+			std::swap(current, next);
+		}
+		if (format == BakedRGBA8) {
+			std::memcpy(out + offsets[l], current.data(), current.size() * sizeof(glm::u8vec4));
+		} else {
+			compress_blocks(format, sizes[l], current.data(), out + offsets[l]);
+		}
+	}
+}
+
+void parse_baked_texture(void const *baked_, size_t baked_bytes, BakedTexture *texture) {
+	assert(texture);
+	uint8_t const *baked = reinterpret_cast< uint8_t const * >(baked_);
+	if (baked_bytes < HeaderSize || std::memcmp(baked, "btex", 4) != 0) {
+		throw std::runtime_error("Not a baked texture.");
+	}
+	if (get_u32(baked + 4) != Version) {
+		throw std::runtime_error("Baked texture is version " + std::to_string(get_u32(baked + 4)) + "; expecting version " + std::to_string(Version) + " (re-bake it).");
+	}
+	uint32_t format = get_u32(baked + 8);
+	if (format != BakedRGBA8 && format != BakedBC1 && format != BakedBC3) {
+		throw std::runtime_error("Baked texture has unknown format " + std::to_string(format) + ".");
+	}
+	texture->format = BakedTextureFormat(format);
+	texture->size = glm::uvec2(get_u32(baked + 12), get_u32(baked + 16));
+	uint32_t levels = get_u32(baked + 20);
+	if (levels == 0 || levels > 32 || baked_bytes < HeaderSize + LevelSize * levels) {
+		throw std::runtime_error("Baked texture has a bad level count.");
+	}
+
+	texture->levels.clear();
+	glm::uvec2 expected = texture->size;
+	for (uint32_t l = 0; l < levels; ++l) {
+		uint8_t const *entry = baked + HeaderSize + LevelSize * l;
+		BakedTexture::Level level;
+		level.size = glm::uvec2(get_u32(entry), get_u32(entry + 4));
+		uint64_t offset = get_u64(entry + 8);
+		uint64_t bytes = get_u64(entry + 16);
+		if (level.size != expected || bytes != level_bytes(texture->format, level.size) || offset > baked_bytes || bytes > baked_bytes - offset) {
+			throw std::runtime_error("Baked texture level " + std::to_string(l) + " is malformed.");
+		}
+		level.data = baked + offset;
+		level.bytes = size_t(bytes);
+		texture->levels.emplace_back(level);
+		expected = mip_size(expected);
+	}
+}
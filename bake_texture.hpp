@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * Baked textures: a mip chain, optionally block-compressed, stored in a small
+ *  container that can be memory-mapped and handed to OpenGL level by level
+ *  (see load_baked_texture.hpp) -- no image decode or mipmap generation at load
+ *  time, and BC1/BC3 textures take 1/8 or 1/4 of the video memory of RGBA8.
+ *
+ * Bake with the 'texture-bake' tool (texture_bake.cpp) or bake_texture().
+ *
+ * File layout (all integers little-endian):
+ *   header: "btex", version, format, width, height, level count (six u32s)
+ *   per level: width, height (u32), offset from start of file, size in bytes (u64)
+ *   level data, each starting at a multiple of 16 bytes.
+ * Pixel rows (and rows of 4x4 blocks) are stored bottom-to-top, as OpenGL expects.
+ */
+
+enum BakedTextureFormat : uint32_t {
+	BakedRGBA8 = 0, //uncompressed
+	BakedBC1 = 1, //a.k.a. DXT1: RGB, 8 bytes per 4x4 block (alpha is dropped)
+	BakedBC3 = 2, //a.k.a. DXT5: RGBA, 16 bytes per 4x4 block
+};
+
+//a parsed baked texture; level data points into the memory that was parsed:
+struct BakedTexture {
+	BakedTextureFormat format = BakedRGBA8;
+	glm::uvec2 size = glm::uvec2(0);
+	struct Level {
+		glm::uvec2 size;
+		uint8_t const *data;
+		size_t bytes;
+	};
+	std::vector< Level > levels;
+};
+
+//bake an image (rows bottom-to-top) into *baked; 'mipmaps' = false stores only the image itself:
+void bake_texture(glm::uvec2 size, glm::u8vec4 const *data, BakedTextureFormat format, bool mipmaps, std::vector< uint8_t > *baked);
+
+//check and index a baked texture in memory (throws if it is malformed):
+void parse_baked_texture(void const *baked, size_t baked_bytes, BakedTexture *texture);
+
+//----- building blocks (used by bake_texture, and for drivers without S3TC) -----
+
+//size of the next mip level:
+inline glm::uvec2 mip_size(glm::uvec2 size) {
+	return glm::uvec2(std::max(1U, size.x / 2), std::max(1U, size.y / 2));
+}
+
+//2x2 box filter 'from' (of 'size') into 'to' (of mip_size(size)); SSE2 on x86-64:
+void downsample(glm::uvec2 size, glm::u8vec4 const *from, glm::u8vec4 *to);
+
+//bytes of compressed data for an image of 'size' ('format' must not be BakedRGBA8):
+size_t compressed_size(BakedTextureFormat format, glm::uvec2 size);
+
+//block-compress an image / decompress blocks back into an image:
+void compress_blocks(BakedTextureFormat format, glm::uvec2 size, glm::u8vec4 const *data, uint8_t *blocks);
+void decompress_blocks(BakedTextureFormat format, glm::uvec2 size, uint8_t const *blocks, glm::u8vec4 *data);
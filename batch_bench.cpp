@@ -0,0 +1,102 @@
+//pong-batch-bench measures PongBatch throughput for each available kernel.
+// usage: pong-batch-bench [matches] [seconds-per-match] [chase|predict]
+//Every kernel runs the same matches from the same starting state; the SIMD
+// kernels' final states are checked against the scalar kernel's.
+//The last argument picks the ai: chase the ball (default) or predict where it's going.
+
+#include "PongBatch.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	uint32_t matches = 4096;
+	float seconds = 30.0f;
+	bool predictive_ai = false;
+
+	//same fixed step that the main loop uses (Mode::Tick):
+	const float Tick = 1.0f / 120.0f;
+
+	try {
+		if (argc > 1) matches = uint32_t(std::stoul(argv[1]));
+		if (argc > 2) seconds = std::stof(argv[2]);
+		if (argc > 3) {
+			std::string ai = argv[3];
+			if (ai == "predict") predictive_ai = true;
+			else if (ai != "chase") throw std::invalid_argument("ai should be 'chase' or 'predict'");
+		}
+		if (argc > 4) throw std::invalid_argument("too many arguments");
+	} catch (std::exception const &e) {
+		std::cerr << "Usage:\n\t" << argv[0] << " [matches] [seconds-per-match] [chase|predict]\n(" << e.what() << ")" << std::endl;
+		return 1;
+	}
+
+	uint32_t steps = uint32_t(seconds / Tick + 0.5f);
+	double total_steps = double(matches) * double(steps);
+
+	std::cout << matches << " matches x " << steps << " steps (" << (predictive_ai ? "predictive" : "chasing") << " ai):" << std::endl;
+
+	auto report = [&](std::string const &name, double elapsed) {
+		std::cout << "  " << name << ": " << elapsed << "s, " << (total_steps / elapsed) << " match-steps/second" << std::endl;
+	};
+
+	//baseline: one PongGame object per match (includes trail upkeep, which PongBatch skips):
+	std::vector< PongGame > games(matches);
+	for (uint32_t i = 0; i < matches; ++i) {
+		games[i].left_ai = true;
+		games[i].continuous_collision = false; //PongBatch uses the discrete collision rules
+		games[i].rng = CounterRNG(0, i);
+		games[i].predictive_ai = predictive_ai;
+	}
+	{
+		auto before = std::chrono::high_resolution_clock::now();
+		for (uint32_t step = 0; step < steps; ++step) {
+			for (auto &game : games) game.update(Tick);
+		}
+		auto after = std::chrono::high_resolution_clock::now();
+		report("PongGame objects", std::chrono::duration< double >(after - before).count());
+	}
+
+	bool all_match = true;
+	for (PongBatch::Kernel kernel : { PongBatch::Scalar, PongBatch::SSE, PongBatch::AVX2 }) {
+		std::string name = std::string("PongBatch ") + PongBatch::kernel_name(kernel);
+		if (!PongBatch::kernel_supported(kernel)) {
+			std::cout << "  " << name << ": not supported on this build/CPU." << std::endl;
+			continue;
+		}
+
+		PongBatch batch(matches);
+		batch.predictive_ai = predictive_ai;
+		auto before = std::chrono::high_resolution_clock::now();
+		for (uint32_t step = 0; step < steps; ++step) {
+			batch.update(Tick, kernel);
+		}
+		auto after = std::chrono::high_resolution_clock::now();
+		report(name, std::chrono::duration< double >(after - before).count());
+
+		//compare against the PongGame objects bit-for-bit:
+		uint32_t mismatches = 0;
+		for (uint32_t i = 0; i < matches; ++i) {
+			PongGame const &a = games[i];
+			PongGame b = batch.get(i);
+			if (std::memcmp(&a.ball, &b.ball, sizeof(a.ball)) != 0
+			 || std::memcmp(&a.ball_velocity, &b.ball_velocity, sizeof(a.ball_velocity)) != 0
+			 || std::memcmp(&a.left_paddle, &b.left_paddle, sizeof(a.left_paddle)) != 0
+			 || std::memcmp(&a.right_paddle, &b.right_paddle, sizeof(a.right_paddle)) != 0
+			 || a.left_score != b.left_score || a.right_score != b.right_score) {
+				++mismatches;
+			}
+		}
+		if (mismatches) {
+			std::cout << "    ERROR: " << mismatches << " matches differ from the PongGame objects." << std::endl;
+			all_match = false;
+		} else {
+			std::cout << "    (final state identical to PongGame objects)" << std::endl;
+		}
+	}
+
+	return all_match ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+
+//does 'filename' end with 'extension' (e.g., ".qoi")? (case-sensitive)
+inline bool has_extension(std::string const &filename, char const *extension) {
+	size_t length = std::strlen(extension);
+	return filename.size() >= length && filename.compare(filename.size() - length, length, extension) == 0;
+}
@@ -1,10 +1,20 @@
 #include "gl_compile_program.hpp"
 
+#include "MappedFile.hpp"
+#include "gl_extensions.hpp"
+
+#include <chrono>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <vector>
 #include <string>
 #include <stdexcept>
 #include <iostream>
 
+GLProgramCache gl_program_cache;
+
 static GLuint gl_compile_shader(GLenum type, std::string const &source) {
 	GLuint shader = glCreateShader(type);
 	GLchar const *str = source.c_str();
@@ -27,9 +37,115 @@ static GLuint gl_compile_shader(GLenum type, std::string const &source) {
 	return shader;
 }
 
-GLuint gl_compile_program(
+//----- program binary cache -----
+//cache files are named by one hash of the source + driver; a second hash (with a different seed) is stored inside to catch collisions.
+//cache file layout (native byte order, since the file only makes sense to this machine's driver anyway):
+struct ProgramCacheHeader {
+	char magic[4]; //"glpb"
+	uint32_t version;
+	uint64_t check; //second hash
+	uint32_t format; //binary format (from glGetProgramBinary)
+	uint32_t length; //bytes of binary that follow
+};
+static const uint32_t ProgramCacheVersion = 1;
+
+//FNV-1a, over a string plus a terminating zero (so "ab","c" and "a","bc" hash differently):
+static uint64_t hash_string(uint64_t hash, std::string const &str) {
+	for (char c : str) {
+		hash = (hash ^ uint8_t(c)) * 0x100000001b3ULL;
+	}
+	return hash * 0x100000001b3ULL; //(same as hashing a zero byte)
+}
+
+static uint64_t hash_program(uint64_t seed, std::string const &vertex_shader_source, std::string const &fragment_shader_source) {
+	//the driver identity is the same for every program, so only look it up once:
+	static std::string driver;
+	if (driver.empty()) {
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+			GLubyte const *str = glGetString(name);
+			driver += (str ? reinterpret_cast< char const * >(str) : "?");
+			driver += '\n';
+		}
+	}
+	uint64_t hash = seed;
+	hash = hash_string(hash, driver);
+	hash = hash_string(hash, vertex_shader_source);
+	hash = hash_string(hash, fragment_shader_source);
+	return hash;
+}
+
+//try to load a cached program (returns 0 if it isn't cached or the driver rejects it):
+static GLuint load_cached_program(std::string const &filename, uint64_t check) {
+	std::unique_ptr< MappedFile > file;
+	try {
+		file.reset(new MappedFile(filename));
+	} catch (std::runtime_error &) {
+		return 0; //(not cached)
+	}
+	ProgramCacheHeader header;
+	if (file->size < sizeof(header)) return 0;
+	std::memcpy(&header, file->data, sizeof(header));
+	if (std::memcmp(header.magic, "glpb", 4) != 0
+	 || header.version != ProgramCacheVersion
+	 || header.check != check
+	 || header.length != file->size - sizeof(header)) {
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	gl_extensions.ProgramBinary(program, header.format, file->data + sizeof(header), GLsizei(header.length));
+	GLint link_status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+	if (link_status != GL_TRUE) {
+		glDeleteProgram(program);
+		gl_program_cache.rejected += 1;
+		return 0;
+	}
+	return program;
+}
+
+static void save_cached_program(std::string const &filename, uint64_t check, GLuint program) {
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+
+	ProgramCacheHeader header;
+	std::memcpy(header.magic, "glpb", 4);
+	header.version = ProgramCacheVersion;
+	header.check = check;
+	std::vector< uint8_t > data(sizeof(header) + size_t(length));
+	GLsizei written = 0;
+	GLenum format = 0;
+	gl_extensions.GetProgramBinary(program, length, &written, &format, data.data() + sizeof(header));
+	if (written <= 0) return;
+	header.format = format;
+	header.length = uint32_t(written);
+	std::memcpy(data.data(), &header, sizeof(header));
+	data.resize(sizeof(header) + size_t(written));
+
+	//write to a temporary file, then rename it into place, so a crash (or another copy of the game) never sees a partial file:
+	std::string temp = filename + ".tmp";
+	{
+		std::ofstream file(temp, std::ios::binary);
+		if (!file.write(reinterpret_cast< char const * >(data.data()), data.size())) {
+			static bool warned = false;
+			if (!warned) std::cerr << "NOTE: can't write shader program cache file '" << temp << "'; programs won't be cached." << std::endl;
+			warned = true;
+			return;
+		}
+	}
+	std::remove(filename.c_str()); //(rename won't replace an existing file on Windows)
+	if (std::rename(temp.c_str(), filename.c_str()) != 0) {
+		std::remove(temp.c_str());
+	}
+}
+
+//----- compiling -----
+
+static GLuint compile_program(
 	std::string const &vertex_shader_source,
-	std::string const &fragment_shader_source
+	std::string const &fragment_shader_source,
+	bool retrievable
 	) {
 
 	GLuint vertex_shader = gl_compile_shader(GL_VERTEX_SHADER, vertex_shader_source);
@@ -43,6 +159,9 @@ GLuint gl_compile_program(
 	glDeleteShader(vertex_shader);
 	glDeleteShader(fragment_shader);
 
+	//(ask the driver to keep the linked binary around, if it will be saved to the cache:)
+	if (retrievable) gl_extensions.ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 	//link the shader program and throw errors if linking fails:
 	glLinkProgram(program);
 	GLint link_status = GL_FALSE;
@@ -60,3 +179,32 @@ GLuint gl_compile_program(
 
 	return program;
 }
+
+GLuint gl_compile_program(
+	std::string const &vertex_shader_source,
+	std::string const &fragment_shader_source
+	) {
+	auto before = std::chrono::high_resolution_clock::now();
+
+	bool cache = (!gl_program_cache.directory.empty() && gl_extensions.ARB_get_program_binary);
+	std::string filename;
+	uint64_t check = 0;
+	GLuint program = 0;
+	if (cache) {
+		char name[32];
+		std::snprintf(name, sizeof(name), "program-%016llx.bin", (unsigned long long)hash_program(0xcbf29ce484222325ULL, vertex_shader_source, fragment_shader_source));
+		filename = gl_program_cache.directory + name;
+		check = hash_program(0x84222325cbf29ce4ULL, vertex_shader_source, fragment_shader_source);
+		program = load_cached_program(filename, check);
+		if (program) gl_program_cache.hits += 1;
+	}
+
+	if (!program) {
+		program = compile_program(vertex_shader_source, fragment_shader_source, cache);
+		gl_program_cache.compiled += 1;
+		if (cache) save_cached_program(filename, check, program);
+	}
+
+	gl_program_cache.ms += std::chrono::duration< double, std::milli >(std::chrono::high_resolution_clock::now() - before).count();
+	return program;
+}
@@ -9,3 +9,21 @@
 GLuint gl_compile_program(
 	std::string const &vertex_shader_source,
 	std::string const &fragment_shader_source);
+
+//gl_compile_program can keep linked programs on disk (using ARB_get_program_binary),
+// keyed by a hash of the source and of the driver's vendor/renderer/version strings.
+// Later runs load the saved binary instead of compiling; if the driver rejects it
+// (e.g., after a driver update), the program is compiled (and re-saved) as usual.
+struct GLProgramCache {
+	//where to keep programs ("" = don't cache); filenames are appended directly, so end it with a separator:
+	// (entries for old versions of shaders are never cleaned up -- delete the files to clear the cache)
+	std::string directory;
+
+	//statistics:
+	uint32_t hits = 0; //programs loaded from the cache
+	uint32_t compiled = 0; //programs compiled from source
+	uint32_t rejected = 0; //cached programs the driver wouldn't load
+	double ms = 0.0; //total time spent in gl_compile_program
+};
+
+extern GLProgramCache gl_program_cache;
@@ -1,12 +1,21 @@
 #pragma once
 
 #include "GL.hpp"
+#include "gl_extensions.hpp"
 #include <iostream>
 
 #define STR2(X) # X
 #define STR(X) STR2(X)
 
-inline void gl_errors(std::string const &where) {
+//GL_ERRORS() reports OpenGL errors that happened since the last call.
+// - in release builds (NDEBUG), it compiles to nothing.
+// - if the driver reports errors through the KHR_debug callback (see gl_extensions.cpp), it does nothing,
+//    since polling glGetError() can stall the pipeline on some drivers.
+// - otherwise, it polls glGetError().
+
+inline void gl_errors(char const *where) {
+	if (gl_extensions.debug_output) return;
+
 	GLenum err = 0;
 	while ((err = glGetError()) != GL_NO_ERROR) {
 		#define CHECK( ERR ) \
@@ -27,5 +36,31 @@ inline void gl_errors(std::string const &where) {
 		#undef CHECK
 	}
 }
+
+#ifdef NDEBUG
+#define GL_ERRORS() ((void)0)
+#else
 #define GL_ERRORS() gl_errors(__FILE__  ":" STR(__LINE__) )
+#endif
+
+//Debug groups and object labels show up in debug messages and in tools like RenderDoc.
+// (they do nothing without KHR_debug, and compile to nothing in release builds)
 
+//name an object: 'identifier' is GL_BUFFER, GL_PROGRAM, GL_VERTEX_ARRAY, GL_TEXTURE, etc:
+inline void gl_label(GLenum identifier, GLuint name, char const *label) {
+	#ifndef NDEBUG
+	if (gl_extensions.KHR_debug) gl_extensions.ObjectLabel(identifier, name, -1, label);
+	#endif
+}
+
+//bracket a section of drawing:
+inline void gl_push_group(char const *name) {
+	#ifndef NDEBUG
+	if (gl_extensions.KHR_debug) gl_extensions.PushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+	#endif
+}
+inline void gl_pop_group() {
+	#ifndef NDEBUG
+	if (gl_extensions.KHR_debug) gl_extensions.PopDebugGroup();
+	#endif
+}
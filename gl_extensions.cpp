@@ -0,0 +1,81 @@
+#include "gl_extensions.hpp"
+
+#include <SDL.h>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+GLExtensions gl_extensions;
+
+//fetch an entry point; returns false if it is missing:
+template< typename FN >
+static bool load(FN *fn, char const *name) {
+	*fn = reinterpret_cast< FN >(SDL_GL_GetProcAddress(name));
+	return *fn != nullptr;
+}
+
+#ifndef NDEBUG
+//KHR_debug message callback:
+static void APIENTRY debug_message(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, GLchar const *message, void const *userParam) {
+	char const *what = "message";
+	if (type == GL_DEBUG_TYPE_ERROR) what = "error";
+	else if (type == GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR || type == GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR) what = "misuse";
+	else if (type == GL_DEBUG_TYPE_PORTABILITY) what = "portability warning";
+	else if (type == GL_DEBUG_TYPE_PERFORMANCE) what = "performance warning";
+	std::cerr << "WARNING: gl " << what << " (id " << id << "): " << std::string(message, length > 0 ? size_t(length) : std::strlen(message)) << std::endl;
+}
+#endif
+
+void init_GL_extensions() {
+	GLExtensions &ext = gl_extensions;
+
+	if (SDL_GL_ExtensionSupported("GL_ARB_buffer_storage")) {
+		ext.ARB_buffer_storage = load(&ext.BufferStorage, "glBufferStorage");
+	}
+
+	if (SDL_GL_ExtensionSupported("GL_KHR_debug")) {
+		ext.KHR_debug =
+			load(&ext.DebugMessageCallback, "glDebugMessageCallback")
+			&& load(&ext.DebugMessageControl, "glDebugMessageControl")
+			&& load(&ext.PushDebugGroup, "glPushDebugGroup")
+			&& load(&ext.PopDebugGroup, "glPopDebugGroup")
+			&& load(&ext.ObjectLabel, "glObjectLabel");
+	}
+
+	if (SDL_GL_ExtensionSupported("GL_ARB_get_program_binary")) {
+		//(some drivers have the extension but no formats, which makes it useless)
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		ext.ARB_get_program_binary = formats > 0
+			&& load(&ext.GetProgramBinary, "glGetProgramBinary")
+			&& load(&ext.ProgramBinary, "glProgramBinary")
+			&& load(&ext.ProgramParameteri, "glProgramParameteri");
+	}
+
+	ext.EXT_texture_compression_s3tc = SDL_GL_ExtensionSupported("GL_EXT_texture_compression_s3tc");
+
+	#ifndef NDEBUG
+	//in debug builds of debug contexts, have the driver report problems as they happen:
+	GLint flags = 0;
+	glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+	if (ext.KHR_debug && (flags & GL_CONTEXT_FLAG_DEBUG_BIT)) {
+		ext.DebugMessageCallback(debug_message, nullptr);
+		//notifications are chatty (e.g., "buffer will use video memory"), so skip them:
+		ext.DebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+		//as are our own debug groups:
+		ext.DebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_PUSH_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+		ext.DebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_POP_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+		glEnable(GL_DEBUG_OUTPUT);
+		//deliver messages during the offending call, so a breakpoint in debug_message() shows the culprit:
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		ext.debug_output = true;
+	}
+	#endif
+
+	std::cout << "GL extensions:"
+		<< " ARB_buffer_storage " << (ext.ARB_buffer_storage ? "yes" : "no") << ";"
+		<< " KHR_debug " << (ext.KHR_debug ? (ext.debug_output ? "yes (messages on)" : "yes") : "no") << ";"
+		<< " ARB_get_program_binary " << (ext.ARB_get_program_binary ? "yes" : "no") << ";"
+		<< " EXT_texture_compression_s3tc " << (ext.EXT_texture_compression_s3tc ? "yes" : "no") << "." << std::endl;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "GL.hpp"
+
+/*
+ * OpenGL features beyond the 3.3 core profile in GL.hpp, which the code uses
+ *  when the driver has them (and works around when it doesn't).
+ * Call init_GL_extensions() after init_GL(); it never throws -- anything missing
+ *  is just left unavailable.
+ *
+ * (Entry points live in a struct rather than as gl* globals so they can't
+ *  collide with symbols exported by the system's OpenGL library.)
+ */
+
+//ARB_buffer_storage (core in 4.4):
+#define GL_MAP_PERSISTENT_BIT             0x0040
+#define GL_MAP_COHERENT_BIT               0x0080
+#define GL_DYNAMIC_STORAGE_BIT            0x0100
+#define GL_CLIENT_STORAGE_BIT             0x0200
+
+//KHR_debug (core in 4.3):
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS       0x8242
+#define GL_DEBUG_SOURCE_API               0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM     0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER   0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY       0x8249
+#define GL_DEBUG_SOURCE_APPLICATION       0x824A
+#define GL_DEBUG_SOURCE_OTHER             0x824B
+#define GL_DEBUG_TYPE_ERROR               0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR  0x824E
+#define GL_DEBUG_TYPE_PORTABILITY         0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE         0x8250
+#define GL_DEBUG_TYPE_OTHER               0x8251
+#define GL_DEBUG_TYPE_MARKER              0x8268
+#define GL_DEBUG_TYPE_PUSH_GROUP          0x8269
+#define GL_DEBUG_TYPE_POP_GROUP           0x826A
+#define GL_DEBUG_SEVERITY_HIGH            0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM          0x9147
+#define GL_DEBUG_SEVERITY_LOW             0x9148
+#define GL_DEBUG_SEVERITY_NOTIFICATION    0x826B
+#define GL_BUFFER                         0x82E0
+#define GL_PROGRAM                        0x82E2
+#define GL_DEBUG_OUTPUT                   0x92E0
+#define GL_CONTEXT_FLAG_DEBUG_BIT         0x00000002
+
+//ARB_get_program_binary (core in 4.1):
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH          0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS     0x87FE
+
+//EXT_texture_compression_s3tc (BC1-3; on essentially every desktop driver, but never made core):
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT   0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT  0x83F3
+
+typedef void (APIENTRY *GLDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, GLchar const *message, void const *userParam);
+
+struct GLExtensions {
+	//ARB_buffer_storage: immutable buffers that can stay mapped while the GPU reads them:
+	bool ARB_buffer_storage = false;
+	void (APIENTRY *BufferStorage)(GLenum target, GLsizeiptr size, void const *data, GLbitfield flags) = nullptr;
+
+	//KHR_debug: messages from the driver via callback, plus object labels and debug groups for tools:
+	bool KHR_debug = false;
+	void (APIENTRY *DebugMessageCallback)(GLDEBUGPROC callback, void const *userParam) = nullptr;
+	void (APIENTRY *DebugMessageControl)(GLenum source, GLenum type, GLenum severity, GLsizei count, GLuint const *ids, GLboolean enabled) = nullptr;
+	void (APIENTRY *PushDebugGroup)(GLenum source, GLuint id, GLsizei length, GLchar const *message) = nullptr;
+	void (APIENTRY *PopDebugGroup)() = nullptr;
+	void (APIENTRY *ObjectLabel)(GLenum identifier, GLuint name, GLsizei length, GLchar const *label) = nullptr;
+	//set if the debug message callback is installed (so GL_ERRORS() doesn't need to poll):
+	bool debug_output = false;
+
+	//ARB_get_program_binary: save linked programs and load them back later without compiling:
+	// (only set if the driver offers at least one binary format)
+	bool ARB_get_program_binary = false;
+	void (APIENTRY *GetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary) = nullptr;
+	void (APIENTRY *ProgramBinary)(GLuint program, GLenum binaryFormat, void const *binary, GLsizei length) = nullptr;
+	void (APIENTRY *ProgramParameteri)(GLuint program, GLenum pname, GLint value) = nullptr;
+
+	//EXT_texture_compression_s3tc: upload BC1/BC3 textures with glCompressedTexImage2D (no new entry points):
+	bool EXT_texture_compression_s3tc = false;
+};
+
+extern GLExtensions gl_extensions;
+
+void init_GL_extensions();
@@ -0,0 +1,145 @@
+//pong-headless steps AI-vs-AI Pong matches without creating a window or OpenGL context.
+// usage: pong-headless [matches] [seconds-per-match] [seed] [chase|predict] [max-speed]
+//    or: pong-headless --multiball [balls] [seconds] [seed]
+//It reports how many simulation steps per second the CPU manages, which makes it
+// handy for benchmarking the game rules on machines without a display.
+//Match i draws random numbers from CounterRNG(seed, i), so a run is exactly
+// reproducible; the printed checksum makes that easy to confirm.
+//The fourth argument picks the ai: chase the ball (default) or predict where it's going.
+//The last sets PongState::max_speed_multiplier (default 10, as in the game); since matches
+// use continuous collision, it can be raised (e.g., to 1000) to keep long matches from stalling.
+//With --multiball it instead steps one MultiBallGame, as a stress test for the
+// ball-vs-ball broadphase.
+
+#include "PongGame.hpp"
+#include "MultiBallGame.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//steps a single MultiBallGame and reports ball-steps/second:
+static int multiball(uint32_t balls, float seconds, uint64_t seed, float Tick) {
+	MultiBallGame game(balls, seed);
+	game.left_ai = true;
+
+	uint32_t steps = uint32_t(seconds / Tick + 0.5f);
+
+	uint64_t pair_tests = 0;
+	auto before = std::chrono::high_resolution_clock::now();
+	for (uint32_t step = 0; step < steps; ++step) {
+		game.update(Tick);
+		pair_tests += game.pair_tests;
+	}
+	auto after = std::chrono::high_resolution_clock::now();
+	double elapsed = std::chrono::duration< double >(after - before).count();
+
+	uint64_t checksum = 0xcbf29ce484222325ull; //FNV-1a over the final scores and ball positions
+	auto hash = [&checksum](uint32_t w) {
+		checksum = (checksum ^ w) * 0x100000001b3ull;
+	};
+	hash(game.left_score);
+	hash(game.right_score);
+	for (auto const &ball : game.balls) {
+		uint32_t words[2];
+		std::memcpy(words, &ball, 8);
+		hash(words[0]);
+		hash(words[1]);
+	}
+
+	std::cout << "Simulated " << balls << " balls for " << seconds << "s (" << steps << " steps) in " << elapsed << "s." << std::endl;
+	std::cout << "  " << (double(balls) * steps / elapsed) << " ball-steps/second; "
+	          << (seconds / elapsed) << "x real time." << std::endl;
+	std::cout << "  " << (double(pair_tests) / steps) << " ball-vs-ball tests per step (vs. " << (double(balls) * (balls - 1) / 2) << " for all pairs)." << std::endl;
+	std::cout << "  score " << game.left_score << " - " << game.right_score << "; checksum " << std::hex << checksum << std::dec << "." << std::endl;
+
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	uint32_t matches = 1000;
+	float seconds = 60.0f;
+	uint64_t seed = 0;
+	bool predictive_ai = false;
+	float max_speed = PongState().max_speed_multiplier;
+
+	//same fixed step that the main loop uses (Mode::Tick):
+	const float Tick = 1.0f / 120.0f;
+
+	if (argc > 1 && std::string(argv[1]) == "--multiball") {
+		uint32_t balls = 5000;
+		seconds = 10.0f;
+		try {
+			if (argc > 2) balls = uint32_t(std::stoul(argv[2]));
+			if (argc > 3) seconds = std::stof(argv[3]);
+			if (argc > 4) seed = std::stoull(argv[4]);
+			if (argc > 5) throw std::invalid_argument("too many arguments");
+		} catch (std::exception const &e) {
+			std::cerr << "Usage:\n\t" << argv[0] << " --multiball [balls] [seconds] [seed]\n(" << e.what() << ")" << std::endl;
+			return 1;
+		}
+		return multiball(balls, seconds, seed, Tick);
+	}
+
+	try {
+		if (argc > 1) matches = uint32_t(std::stoul(argv[1]));
+		if (argc > 2) seconds = std::stof(argv[2]);
+		if (argc > 3) seed = std::stoull(argv[3]);
+		if (argc > 4) {
+			std::string ai = argv[4];
+			if (ai == "predict") predictive_ai = true;
+			else if (ai != "chase") throw std::invalid_argument("ai should be 'chase' or 'predict'");
+		}
+		if (argc > 5) max_speed = std::stof(argv[5]);
+		if (argc > 6) throw std::invalid_argument("too many arguments");
+	} catch (std::exception const &e) {
+		std::cerr << "Usage:\n\t" << argv[0] << " [matches] [seconds-per-match] [seed] [chase|predict] [max-speed]\n(" << e.what() << ")" << std::endl;
+		return 1;
+	}
+
+	std::vector< PongGame > games(matches);
+	for (uint32_t i = 0; i < matches; ++i) {
+		games[i].left_ai = true;
+		games[i].rng = CounterRNG(seed, i);
+		games[i].predictive_ai = predictive_ai;
+		games[i].max_speed_multiplier = max_speed;
+	}
+
+	uint32_t steps = uint32_t(seconds / Tick + 0.5f);
+
+	auto before = std::chrono::high_resolution_clock::now();
+	for (auto &game : games) {
+		for (uint32_t step = 0; step < steps; ++step) {
+			game.update(Tick);
+		}
+	}
+	auto after = std::chrono::high_resolution_clock::now();
+	double elapsed = std::chrono::duration< double >(after - before).count();
+
+	uint64_t points = 0;
+	uint64_t plans = 0;
+	uint64_t checksum = 0xcbf29ce484222325ull; //FNV-1a over the final scores and ball positions
+	for (auto const &game : games) {
+		points += game.left_score + game.right_score;
+		plans += game.ai_plans;
+		uint32_t words[4] = { game.left_score, game.right_score, 0, 0 };
+		std::memcpy(&words[2], &game.ball.x, 4);
+		std::memcpy(&words[3], &game.ball.y, 4);
+		for (uint32_t w : words) {
+			checksum = (checksum ^ w) * 0x100000001b3ull;
+		}
+	}
+
+	double total_steps = double(matches) * double(steps);
+	std::cout << "Simulated " << matches << " matches of " << seconds << "s (" << steps << " steps each) in " << elapsed << "s." << std::endl;
+	std::cout << "  " << (total_steps / elapsed) << " match-steps/second; "
+	          << (matches * double(seconds) / elapsed) << "x real time over all matches." << std::endl;
+	std::cout << "  " << points << " points scored in total; checksum " << std::hex << checksum << std::dec << "." << std::endl;
+	if (predictive_ai) {
+		std::cout << "  " << plans << " ai predictions (" << (plans / total_steps) << " per step)." << std::endl;
+	}
+
+	return 0;
+}
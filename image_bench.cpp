@@ -0,0 +1,100 @@
+//image-bench compares encode/decode speed (and size) of the PNG and QOI codecs on real images, e.g., screenshots.
+// usage: image-bench [image.png ...] (default: screenshot.png, as saved by the game's PRINTSCREEN key)
+//Speeds are in MB/s of raw RGBA pixels; each number is the best of several runs, in memory (no disk I/O).
+//Each codec's output is decoded and checked against the original pixels.
+
+#include "load_save_png.hpp"
+#include "load_save_qoi.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//best time (in seconds) of a few runs of 'fn', running for at least a little while:
+static double best_time(std::function< void() > const &fn) {
+	double best = 1e30;
+	double total = 0.0;
+	for (uint32_t run = 0; run < 50 && (run < 3 || total < 1.0); ++run) {
+		auto before = std::chrono::high_resolution_clock::now();
+		fn();
+		double seconds = std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count();
+		best = std::min(best, seconds);
+		total += seconds;
+	}
+	return best;
+}
+
+int main(int argc, char **argv) {
+	std::vector< std::string > filenames(argv + 1, argv + argc);
+	if (filenames.empty()) filenames.emplace_back("screenshot.png");
+	for (auto const &filename : filenames) {
+		if (!filename.empty() && filename[0] == '-') {
+			std::cerr << "Usage:\n\t" << argv[0] << " [image.png ...]" << std::endl;
+			return 1;
+		}
+	}
+
+	for (auto const &filename : filenames) {
+		glm::uvec2 size;
+		std::vector< glm::u8vec4 > original;
+		try {
+			load_png(filename, &size, &original, LowerLeftOrigin);
+		} catch (std::exception const &e) {
+			std::cerr << e.what() << std::endl;
+			return 1;
+		}
+		double megabytes = double(original.size() * sizeof(glm::u8vec4)) / (1024.0 * 1024.0);
+		std::cout << filename << ": " << size.x << "x" << size.y << " (" << megabytes << " MB raw)" << std::endl;
+
+		std::vector< glm::u8vec4 > decoded(original.size());
+		auto report = [&](char const *name, std::vector< uint8_t > const &encoded, double encode_seconds, double decode_seconds) {
+			char line[200];
+			std::snprintf(line, sizeof(line), "  %-22s %9zu bytes (%5.1f%%)   encode %8.1f MB/s   decode %8.1f MB/s%s",
+				name, encoded.size(), 100.0 * double(encoded.size()) / (megabytes * 1024.0 * 1024.0),
+				megabytes / encode_seconds, megabytes / decode_seconds,
+				(decoded == original ? "" : "   MISMATCH!")
+			);
+			std::cout << line << std::endl;
+			std::fill(decoded.begin(), decoded.end(), glm::u8vec4(0)); //(so the next codec's check starts fresh)
+		};
+
+		glm::uvec2 decoded_size;
+
+		//PNG via libpng (save_png, as it was used for screenshots before; it only writes files, so this includes the write):
+		{
+			std::string temp = "image-bench-temp.png";
+			double encode = best_time([&](){ save_png(temp, size, original.data(), LowerLeftOrigin); });
+			std::vector< uint8_t > encoded;
+			{
+				MappedFile file(temp);
+				encoded.assign(file.data, file.data + file.size);
+			}
+			std::remove(temp.c_str());
+			double decode = best_time([&](){ load_png(encoded.data(), encoded.size(), &decoded_size, decoded.data(), decoded.size(), LowerLeftOrigin); });
+			report("png (libpng)", encoded, encode, decode);
+		}
+
+		//PNG via the strip encoder, at capture and screenshot settings, on one thread:
+		for (int level : { 1, 6 }) {
+			std::vector< uint8_t > encoded;
+			double encode = best_time([&](){ encode_png_parallel(size, original.data(), LowerLeftOrigin, &encoded, level, 1); });
+			double decode = best_time([&](){ load_png(encoded.data(), encoded.size(), &decoded_size, decoded.data(), decoded.size(), LowerLeftOrigin); });
+			report(level == 1 ? "png (strips, level 1)" : "png (strips, level 6)", encoded, encode, decode);
+		}
+
+		//QOI:
+		{
+			std::vector< uint8_t > encoded;
+			double encode = best_time([&](){ encode_qoi(size, original.data(), LowerLeftOrigin, &encoded); });
+			double decode = best_time([&](){ load_qoi(encoded.data(), encoded.size(), &decoded_size, decoded.data(), decoded.size(), LowerLeftOrigin); });
+			report("qoi", encoded, encode, decode);
+		}
+	}
+
+	return 0;
+}
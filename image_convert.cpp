@@ -0,0 +1,62 @@
+//image-convert converts images between PNG and QOI (e.g., to bake assets as QOI for fast loading).
+// usage: image-convert input.png output.qoi
+//        image-convert input.qoi output.png
+//        image-convert --to qoi|png file [file ...] (writes each file next to itself, with the other extension)
+//Images are loaded and saved with the same origin, so rows stay in file order.
+
+#include "load_save_png.hpp"
+#include "load_save_qoi.hpp"
+#include "file_extension.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static void convert(std::string const &from, std::string const &to) {
+	glm::uvec2 size;
+	std::vector< glm::u8vec4 > data;
+	if (has_extension(from, ".png")) load_png(from, &size, &data, UpperLeftOrigin);
+	else if (has_extension(from, ".qoi")) load_qoi(from, &size, &data, UpperLeftOrigin);
+	else throw std::invalid_argument("don't know how to read '" + from + "' (expecting .png or .qoi)");
+
+	if (has_extension(to, ".png")) save_png_parallel(to, size, data.data(), UpperLeftOrigin, 9);
+	else if (has_extension(to, ".qoi")) save_qoi(to, size, data.data(), UpperLeftOrigin);
+	else throw std::invalid_argument("don't know how to write '" + to + "' (expecting .png or .qoi)");
+
+	std::cout << from << " -> " << to << " (" << size.x << "x" << size.y << ")" << std::endl;
+}
+
+int main(int argc, char **argv) {
+	std::vector< std::pair< std::string, std::string > > conversions;
+	try {
+		std::vector< std::string > args(argv + 1, argv + argc);
+		if (args.size() >= 3 && args[0] == "--to") {
+			if (args[1] != "png" && args[1] != "qoi") throw std::invalid_argument("--to should be 'png' or 'qoi'");
+			std::string extension = "." + args[1];
+			for (uint32_t i = 2; i < args.size(); ++i) {
+				std::string const &from = args[i];
+				std::string to = from.substr(0, from.rfind('.')) + extension;
+				if (to == from) throw std::invalid_argument("'" + from + "' is already " + args[1]);
+				conversions.emplace_back(from, to);
+			}
+		} else if (args.size() == 2 && args[0][0] != '-') {
+			conversions.emplace_back(args[0], args[1]);
+		} else {
+			throw std::invalid_argument("expecting two filenames, or --to and a list of files");
+		}
+	} catch (std::exception const &e) {
+		std::cerr << "Usage:\n\t" << argv[0] << " input.(png|qoi) output.(png|qoi)\n\t" << argv[0] << " --to (png|qoi) file [file ...]\n(" << e.what() << ")" << std::endl;
+		return 1;
+	}
+
+	for (auto const &conversion : conversions) {
+		try {
+			convert(conversion.first, conversion.second);
+		} catch (std::exception const &e) {
+			std::cerr << "Failed to convert '" << conversion.first << "': " << e.what() << std::endl;
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,59 @@
+#include "load_baked_texture.hpp"
+
+#include "GLState.hpp"
+#include "MappedFile.hpp"
+#include "gl_errors.hpp"
+#include "gl_extensions.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+GLuint load_baked_texture(std::string const &filename, glm::uvec2 *size) {
+	MappedFile file(filename);
+	BakedTexture baked;
+	try {
+		parse_baked_texture(file.data, file.size, &baked);
+	} catch (std::runtime_error &e) {
+		throw std::runtime_error("Failed to load baked texture '" + filename + "': " + e.what());
+	}
+	GLuint tex = upload_baked_texture(baked);
+	gl_label(GL_TEXTURE, tex, filename.c_str());
+	if (size) *size = baked.size;
+	return tex;
+}
+
+GLuint upload_baked_texture(BakedTexture const &baked, GLenum *internal_format_) {
+	GLuint tex = 0;
+	glGenTextures(1, &tex);
+	gl_state.bind_texture(GL_TEXTURE_2D, tex);
+
+	bool compressed = (baked.format != BakedRGBA8);
+	GLenum internal_format = (baked.format == BakedBC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+	std::vector< glm::u8vec4 > decompressed; //(only used without S3TC)
+	if (internal_format_) *internal_format_ = (compressed && gl_extensions.EXT_texture_compression_s3tc ? internal_format : GL_RGBA8);
+
+	for (uint32_t l = 0; l < baked.levels.size(); ++l) {
+		BakedTexture::Level const &level = baked.levels[l];
+		if (compressed && gl_extensions.EXT_texture_compression_s3tc) {
+			glCompressedTexImage2D(GL_TEXTURE_2D, l, internal_format, level.size.x, level.size.y, 0, GLsizei(level.bytes), level.data);
+		} else if (compressed) {
+			decompressed.resize(size_t(level.size.x) * level.size.y);
+			decompress_blocks(baked.format, level.size, level.data, decompressed.data());
+			glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, level.size.x, level.size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, decompressed.data());
+		} else {
+			glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, level.size.x, level.size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, level.data);
+		}
+	}
+
+	//only the stored levels exist (so the texture is complete even if the chain was cut short):
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(baked.levels.size()) - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (baked.levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+
+	return tex;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "GL.hpp"
+#include "bake_texture.hpp"
+
+#include <glm/glm.hpp>
+
+#include <string>
+
+/*
+ * Upload baked textures (see bake_texture.hpp) to OpenGL.
+ *
+ * Each stored level goes straight from memory to glCompressedTexImage2D (or
+ *  glTexImage2D for RGBA8) -- no decode and no glGenerateMipmap. If the driver
+ *  lacks S3TC, BC1/BC3 levels are decompressed in software first.
+ *
+ * The result is a GL_TEXTURE_2D with trilinear filtering (if it has mipmaps)
+ *  and GL_REPEAT wrapping, left bound to the active texture unit.
+ */
+
+//map 'filename', upload it, and return the new texture's name; sets *size if 'size' isn't null:
+//NOTE: throws on error
+GLuint load_baked_texture(std::string const &filename, glm::uvec2 *size = nullptr);
+
+//upload an already-parsed baked texture; sets *internal_format (if not null) to the format it was uploaded as:
+GLuint upload_baked_texture(BakedTexture const &baked, GLenum *internal_format = nullptr);
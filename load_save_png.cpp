@@ -1,28 +1,36 @@
 #include "load_save_png.hpp"
 
+#include "MappedFile.hpp"
+
 #include <png.h>
+#include <zlib.h>
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <fstream>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
 #define LOG_ERROR( X ) std::cerr << X << std::endl
 
-using std::vector;
-
-bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vector< glm::u8vec4 > *data, OriginLocation origin);
 void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8vec4 const *data, OriginLocation origin);
 
 void load_png(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin) {
 	assert(size);
+	assert(data);
 
-	std::ifstream file(filename.c_str(), std::ios::binary);
-	if (!file) {
-		throw std::runtime_error("Failed to open PNG image file '" + filename + "'.");
-	}
-	if (!load_png(file, &size->x, &size->y, data, origin)) {
-		throw std::runtime_error("Failed to read PNG image from '" + filename + "'.");
+	MappedFile file(filename);
+	try {
+		glm::uvec2 image_size = png_size(file.data, file.size);
+		data->resize(size_t(image_size.x) * image_size.y);
+		load_png(file.data, file.size, size, data->data(), data->size(), origin);
+	} catch (std::runtime_error &e) {
+		throw std::runtime_error("Failed to read PNG image from '" + filename + "': " + e.what());
 	}
 }
 
@@ -32,12 +40,20 @@ void save_png(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, Or
 }
 
 
+//the part of an in-memory PNG that hasn't been read yet:
+struct MemoryReader {
+	uint8_t const *at;
+	uint8_t const *end;
+};
+
 static void user_read_data(png_structp png_ptr, png_bytep data, png_size_t length) {
-	std::istream *from = reinterpret_cast< std::istream * >(png_get_io_ptr(png_ptr));
+	MemoryReader *from = reinterpret_cast< MemoryReader * >(png_get_io_ptr(png_ptr));
 	assert(from);
-	if (!from->read(reinterpret_cast< char * >(data), length)) {
-		png_error(png_ptr, "Error reading.");
+	if (length > size_t(from->end - from->at)) {
+		png_error(png_ptr, "Unexpected end of data.");
 	}
+	std::memcpy(data, from->at, length);
+	from->at += length;
 }
 
 static void user_write_data(png_structp png_ptr, png_bytep data, png_size_t length) {
@@ -57,41 +73,50 @@ static void user_flush_data(png_structp png_ptr) {
 }
 
 
-bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vector< glm::u8vec4 > *data, OriginLocation origin) {
-	assert(data);
-	uint32_t local_width, local_height;
-	if (width == nullptr) width = &local_width;
-	if (height == nullptr) height = &local_height;
-	*width = *height = 0;
-	data->clear();
-	//..... load file ......
-	//Load a png file, as per the libpng docs:
-	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)NULL, (png_error_ptr)NULL, (png_error_ptr)NULL);
+static uint32_t read_u32(uint8_t const *at) {
+	return (uint32_t(at[0]) << 24) | (uint32_t(at[1]) << 16) | (uint32_t(at[2]) << 8) | uint32_t(at[3]);
+}
 
-	png_set_read_fn(png, &from, user_read_data);
+glm::uvec2 png_size(void const *png_, size_t png_bytes) {
+	uint8_t const *png = reinterpret_cast< uint8_t const * >(png_);
+	//signature, then IHDR (which must come first), which starts with width and height:
+	if (png_bytes < 8 + 8 + 8 || png_sig_cmp(png, 0, 8) != 0 || std::memcmp(png + 12, "IHDR", 4) != 0) {
+		throw std::runtime_error("Not a PNG image.");
+	}
+	return glm::uvec2(read_u32(png + 16), read_u32(png + 20));
+}
+
+void load_png(void const *png_, size_t png_bytes, glm::uvec2 *size, glm::u8vec4 *pixels, size_t capacity, OriginLocation origin) {
+	assert(size);
+	*size = glm::uvec2(0);
 
+	MemoryReader reader;
+	reader.at = reinterpret_cast< uint8_t const * >(png_);
+	reader.end = reader.at + png_bytes;
+
+	//Load a png, as per the libpng docs:
+	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)NULL, (png_error_ptr)NULL, (png_error_ptr)NULL);
 	if (!png) {
-		LOG_ERROR("  cannot alloc read struct.");
-		return false;
+		throw std::runtime_error("Cannot alloc read struct.");
 	}
 	png_infop info = png_create_info_struct(png);
 	if (!info) {
-		LOG_ERROR("  cannot alloc info struct.");
 		png_destroy_read_struct(&png, (png_infopp)NULL, (png_infopp)NULL);
-		return false;
+		throw std::runtime_error("Cannot alloc info struct.");
 	}
-	png_bytep *row_pointers = NULL;
 	if (setjmp(png_jmpbuf(png))) {
-		LOG_ERROR("  png interal error.");
 		png_destroy_read_struct(&png, &info, (png_infopp)NULL);
-		if (row_pointers != NULL) delete[] row_pointers;
-		data->clear();
-		return false;
+		throw std::runtime_error("Corrupt or unsupported PNG data.");
 	}
-	//not needed with custom read/write functions: png_init_io(png, NULL);
+	png_set_read_fn(png, &reader, user_read_data);
+
 	png_read_info(png, info);
 	unsigned int w = png_get_image_width(png, info);
 	unsigned int h = png_get_image_height(png, info);
+	if (size_t(w) * h > capacity) {
+		png_destroy_read_struct(&png, &info, (png_infopp)NULL);
+		throw std::runtime_error("Image is " + std::to_string(w) + "x" + std::to_string(h) + ", which doesn't fit in " + std::to_string(capacity) + " pixels.");
+	}
 	if (png_get_color_type(png, info) == PNG_COLOR_TYPE_PALETTE)
 		png_set_palette_to_rgb(png);
 	if (png_get_color_type(png, info) == PNG_COLOR_TYPE_GRAY || png_get_color_type(png, info) == PNG_COLOR_TYPE_GRAY_ALPHA)
@@ -102,29 +127,25 @@ bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vec
 		png_set_packing(png);
 	if (png_get_bit_depth(png,info) == 16)
 		png_set_strip_16(png);
+	int passes = png_set_interlace_handling(png);
 	//Ok, should be 32-bit RGBA now.
 
 	png_read_update_info(png, info);
 	size_t rowbytes = png_get_rowbytes(png, info);
 	//Make sure it's the format we think it is...
 	assert(rowbytes == w*sizeof(uint32_t));
+	(void)rowbytes; //(only checked in debug builds)
 
-	data->resize(w*h);
-	row_pointers = new png_bytep[h];
-	for (unsigned int r = 0; r < h; ++r) {
-		if (origin == LowerLeftOrigin) {
-			row_pointers[h-1-r] = (png_bytep)(&(*data)[r*w]);
-		} else {
-			row_pointers[r] = (png_bytep)(&(*data)[r*w]);
+	//decode rows straight into 'pixels' (the origin flip is just a choice of destination row):
+	for (int pass = 0; pass < passes; ++pass) {
+		for (unsigned int r = 0; r < h; ++r) {
+			unsigned int row = (origin == LowerLeftOrigin ? h-1-r : r);
+			png_read_row(png, (png_bytep)(pixels + size_t(row) * w), NULL);
 		}
 	}
-	png_read_image(png, row_pointers);
 	png_destroy_read_struct(&png, &info, NULL);
-	delete[] row_pointers;
 
-	*width = w;
-	*height = h;
-	return true;
+	*size = glm::uvec2(w, h);
 }
 
 
@@ -157,7 +178,7 @@ void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8
 
 	png_write_info(png_ptr, info_ptr);
 	//png_set_swap_alpha(png_ptr) // might need?
-	vector< png_bytep > row_pointers(height);
+	std::vector< png_bytep > row_pointers(height);
 	for (unsigned int i = 0; i < height; ++i) {
 		if (origin == UpperLeftOrigin) {
 			row_pointers[i] = (png_bytep)&(data[i * width]);
@@ -173,3 +194,228 @@ void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8
 
 	return;
 }
+
+//------------------------------------------------------------------
+//parallel encoder:
+//
+//PNG image data is one zlib stream of filtered rows. Each strip of rows is
+// filtered and deflated on its own thread into raw deflate blocks, ending
+// with a sync flush (so it ends on a byte boundary, without a "last block"
+// flag); the last strip ends the stream. Concatenated, the strips form a
+// valid deflate stream, and the zlib checksum (Adler-32) and IDAT checksum
+// (CRC-32) are combined from per-strip checksums.
+//(Each strip starts with an empty dictionary, which costs a little compression.)
+
+namespace {
+
+//row filters, from the PNG spec; 'bpp' (bytes per pixel) is 4 for RGBA:
+uint8_t paeth(uint8_t a, uint8_t b, uint8_t c) {
+	int p = int(a) + int(b) - int(c);
+	int pa = std::abs(p - int(a));
+	int pb = std::abs(p - int(b));
+	int pc = std::abs(p - int(c));
+	if (pa <= pb && pa <= pc) return a;
+	else if (pb <= pc) return b;
+	else return c;
+}
+
+void filter_row(uint8_t type, uint8_t const *row, uint8_t const *prev, size_t bytes, uint8_t *out) {
+	const size_t bpp = 4;
+	for (size_t i = 0; i < bytes; ++i) {
+		uint8_t a = (i >= bpp ? row[i - bpp] : 0); //left
+		uint8_t b = prev[i]; //up
+		uint8_t c = (i >= bpp ? prev[i - bpp] : 0); //up-left
+		uint8_t predicted;
+		if (type == 0) predicted = 0;
+		else if (type == 1) predicted = a;
+		else if (type == 2) predicted = b;
+		else if (type == 3) predicted = uint8_t((int(a) + int(b)) / 2);
+		else predicted = paeth(a, b, c);
+		out[i] = uint8_t(row[i] - predicted);
+	}
+}
+
+//output of one strip:
+struct Strip {
+	std::vector< uint8_t > deflated;
+	uLong adler = 1; //of the filtered rows
+	uLong filtered_bytes = 0;
+	uLong crc = 0; //of 'deflated'
+	bool ok = false;
+};
+
+//filter + deflate rows [begin, end) (in file order, i.e., top to bottom):
+void encode_strip(uint32_t width, uint32_t height, glm::u8vec4 const *data, OriginLocation origin, int level, uint32_t begin, uint32_t end, bool last, Strip *strip) {
+	size_t row_bytes = size_t(width) * 4;
+	auto row = [&](uint32_t r) -> uint8_t const * {
+		uint32_t data_row = (origin == UpperLeftOrigin ? r : height - 1 - r);
+		return reinterpret_cast< uint8_t const * >(data + size_t(data_row) * width);
+	};
+
+	//filter rows (each prefixed by its filter type):
+	std::vector< uint8_t > filtered((1 + row_bytes) * (end - begin));
+	std::vector< uint8_t > zeros(row_bytes, 0);
+	std::vector< uint8_t > candidate(row_bytes);
+	for (uint32_t r = begin; r < end; ++r) {
+		uint8_t *out = &filtered[(1 + row_bytes) * (r - begin)];
+		uint8_t const *prev = (r > 0 ? row(r - 1) : zeros.data());
+		if (level <= 2) {
+			//fast: always 'sub', which does well on typical screen content
+			out[0] = 1;
+			filter_row(1, row(r), prev, row_bytes, out + 1);
+		} else {
+			//small: try every filter, keep the one with the smallest sum of (signed) residuals, as libpng does
+			uint64_t best_sum = ~uint64_t(0);
+			for (uint8_t type = 0; type < 5; ++type) {
+				filter_row(type, row(r), prev, row_bytes, candidate.data());
+				uint64_t sum = 0;
+				for (uint8_t v : candidate) sum += (v < 128 ? v : 256 - v);
+				if (sum < best_sum) {
+					best_sum = sum;
+					out[0] = type;
+					std::copy(candidate.begin(), candidate.end(), out + 1);
+				}
+			}
+		}
+	}
+	strip->filtered_bytes = uLong(filtered.size());
+	strip->adler = adler32(1, filtered.data(), uInt(filtered.size()));
+
+	//deflate as raw (header-less) blocks:
+	z_stream z;
+	std::memset(&z, 0, sizeof(z));
+	if (deflateInit2(&z, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) return;
+	strip->deflated.resize(deflateBound(&z, uLong(filtered.size())) + 16);
+	z.next_in = filtered.data();
+	z.avail_in = uInt(filtered.size());
+	z.next_out = strip->deflated.data();
+	z.avail_out = uInt(strip->deflated.size());
+	int result = deflate(&z, last ? Z_FINISH : Z_SYNC_FLUSH);
+	bool ok = (last ? result == Z_STREAM_END : result == Z_OK) && z.avail_in == 0;
+	strip->deflated.resize(z.total_out);
+	deflateEnd(&z);
+	if (!ok) return;
+
+	strip->crc = crc32(0, strip->deflated.data(), uInt(strip->deflated.size()));
+	strip->ok = true;
+}
+
+//helper threads running in all encode_png_parallel calls, which share (cores - 1) of them:
+std::atomic< uint32_t > helpers_running{0};
+
+//take up to 'wanted' helpers from the shared budget; returns the number taken:
+uint32_t reserve_helpers(uint32_t wanted) {
+	uint32_t limit = std::max(1U, std::thread::hardware_concurrency()) - 1;
+	uint32_t running = helpers_running.load();
+	while (true) {
+		uint32_t take = std::min(wanted, (running < limit ? limit - running : 0));
+		if (take == 0) return 0;
+		if (helpers_running.compare_exchange_weak(running, running + take)) return take;
+	}
+}
+
+void append_u32(std::vector< uint8_t > *to, uint32_t v) {
+	to->emplace_back(uint8_t(v >> 24));
+	to->emplace_back(uint8_t(v >> 16));
+	to->emplace_back(uint8_t(v >> 8));
+	to->emplace_back(uint8_t(v));
+}
+
+void append_chunk(std::vector< uint8_t > *to, char const *type, std::vector< uint8_t > const &contents) {
+	append_u32(to, uint32_t(contents.size()));
+	size_t start = to->size();
+	to->insert(to->end(), type, type + 4);
+	to->insert(to->end(), contents.begin(), contents.end());
+	append_u32(to, uint32_t(crc32(0, to->data() + start, uInt(to->size() - start))));
+}
+
+} //namespace
+
+void encode_png_parallel(glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin, std::vector< uint8_t > *png, int level, uint32_t threads) {
+	assert(png);
+	assert(level >= 0 && level <= 9);
+	if (threads == 0) threads = std::max(1U, std::thread::hardware_concurrency());
+
+	//split into strips (of at least 32 rows, so each strip has something to compress), one per thread:
+	// (this thread takes one strip; helpers for the rest come from the shared budget, which may be used up)
+	const uint32_t MinRows = 32;
+	uint32_t wanted = std::max(1U, std::min(threads, (size.y + MinRows - 1) / MinRows)) - 1;
+	uint32_t helpers = (wanted ? reserve_helpers(wanted) : 0);
+	uint32_t strip_count = 1 + helpers;
+	std::vector< Strip > strips(strip_count);
+	{
+		std::vector< std::thread > workers;
+		auto run = [&](uint32_t s) {
+			uint32_t begin = uint32_t(uint64_t(size.y) * s / strip_count);
+			uint32_t end = uint32_t(uint64_t(size.y) * (s + 1) / strip_count);
+			encode_strip(size.x, size.y, data, origin, level, begin, end, s + 1 == strip_count, &strips[s]);
+		};
+		for (uint32_t s = 1; s < strip_count; ++s) {
+			workers.emplace_back(run, s);
+		}
+		run(0);
+		for (auto &worker : workers) {
+			worker.join();
+		}
+		helpers_running -= helpers;
+	}
+	for (auto const &strip : strips) {
+		if (!strip.ok) throw std::runtime_error("Failed to compress PNG data.");
+	}
+
+	png->clear();
+	static const uint8_t Signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	png->insert(png->end(), Signature, Signature + 8);
+
+	{ //IHDR:
+		std::vector< uint8_t > ihdr;
+		append_u32(&ihdr, size.x);
+		append_u32(&ihdr, size.y);
+		ihdr.emplace_back(8); //bit depth
+		ihdr.emplace_back(6); //color type: RGBA
+		ihdr.emplace_back(0); //compression: deflate
+		ihdr.emplace_back(0); //filter method: adaptive
+		ihdr.emplace_back(0); //no interlace
+		append_chunk(png, "IHDR", ihdr);
+	}
+
+	{ //IDAT, stitched together from the strips:
+		//zlib header (32K window, deflate; level hint; check bits so header % 31 == 0):
+		uint8_t flevel = (level <= 1 ? 0 : level <= 5 ? 1 : level == 6 ? 2 : 3);
+		uint8_t cmf = 0x78;
+		uint8_t flg = uint8_t(flevel << 6);
+		flg = uint8_t(flg + (31 - (cmf * 256 + flg) % 31));
+
+		uLong adler = 1;
+		size_t length = 2 + 4;
+		for (auto const &strip : strips) {
+			adler = adler32_combine(adler, strip.adler, strip.filtered_bytes);
+			length += strip.deflated.size();
+		}
+		if (length > 0x7fffffff) throw std::runtime_error("PNG data too large for one chunk.");
+
+		append_u32(png, uint32_t(length));
+		size_t start = png->size();
+		png->insert(png->end(), { 'I', 'D', 'A', 'T', cmf, flg });
+		uLong crc = crc32(0, png->data() + start, 6);
+		for (auto const &strip : strips) {
+			png->insert(png->end(), strip.deflated.begin(), strip.deflated.end());
+			crc = crc32_combine(crc, strip.crc, z_off_t(strip.deflated.size()));
+		}
+		size_t trailer = png->size();
+		append_u32(png, uint32_t(adler));
+		crc = crc32(crc, png->data() + trailer, 4);
+		append_u32(png, uint32_t(crc));
+	}
+
+	append_chunk(png, "IEND", std::vector< uint8_t >());
+}
+
+void save_png_parallel(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin, int level, uint32_t threads) {
+	std::vector< uint8_t > png;
+	encode_png_parallel(size, data, origin, &png, level, threads);
+	std::ofstream file(filename.c_str(), std::ios::binary);
+	if (!file.write(reinterpret_cast< char const * >(png.data()), png.size())) {
+		throw std::runtime_error("Failed to write PNG to '" + filename + "'.");
+	}
+}
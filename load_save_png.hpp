@@ -17,4 +17,20 @@ enum OriginLocation {
 
 //NOTE: load_png will throw on error
 void load_png(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin);
+
+//decode a PNG that is already in memory (e.g., a MappedFile, or part of an archive):
+// png_size reads just the image size from the header, so the caller can make room for the pixels;
+// load_png then decodes straight into 'pixels', which must have room for 'capacity' pixels.
+//NOTE: these throw on error (including if the image doesn't fit)
+glm::uvec2 png_size(void const *png, size_t png_bytes);
+void load_png(void const *png, size_t png_bytes, glm::uvec2 *size, glm::u8vec4 *pixels, size_t capacity, OriginLocation origin);
 void save_png(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin);
+
+//save_png, but filtering and compressing horizontal strips of the image on several threads:
+// 'level' is the zlib compression level (1 = fastest ... 9 = smallest, 0 = uncompressed)
+// 'threads' is the most threads to use (0 = one per core), counting the calling thread;
+//  the extra threads come from a budget of one per core (less one) shared by every call,
+//  so encodes running at once (e.g., on a pool of writers) split the cores rather than each taking them all
+//NOTE: these throw on error
+void save_png_parallel(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin, int level = 6, uint32_t threads = 0);
+void encode_png_parallel(glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin, std::vector< uint8_t > *png, int level = 6, uint32_t threads = 0);
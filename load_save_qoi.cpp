@@ -0,0 +1,209 @@
+#include "load_save_qoi.hpp"
+
+#include "MappedFile.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+//format details, from the QOI specification:
+namespace {
+	const uint32_t HeaderSize = 14; //"qoif", width, height, channels, colorspace
+	const uint8_t Padding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 }; //end marker
+
+	const uint8_t OpIndex = 0x00; //00iiiiii: pixel from the index
+	const uint8_t OpDiff  = 0x40; //01rrggbb: small per-channel difference from previous pixel
+	const uint8_t OpLuma  = 0x80; //10gggggg rrrrbbbb: green difference, plus red and blue differences relative to it
+	const uint8_t OpRun   = 0xc0; //11llllll: repeat previous pixel 1-62 times
+	const uint8_t OpRGB   = 0xfe; //then r, g, b
+	const uint8_t OpRGBA  = 0xff; //then r, g, b, a
+	const uint8_t Mask2   = 0xc0;
+
+	//index of recently-seen pixels:
+	inline uint32_t index_of(glm::u8vec4 px) {
+		return (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64;
+	}
+
+	inline uint32_t read_u32(uint8_t const *at) {
+		return (uint32_t(at[0]) << 24) | (uint32_t(at[1]) << 16) | (uint32_t(at[2]) << 8) | uint32_t(at[3]);
+	}
+	inline uint8_t *write_u32(uint8_t *at, uint32_t v) {
+		at[0] = uint8_t(v >> 24);
+		at[1] = uint8_t(v >> 16);
+		at[2] = uint8_t(v >> 8);
+		at[3] = uint8_t(v);
+		return at + 4;
+	}
+}
+
+void load_qoi(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin) {
+	assert(size);
+	assert(data);
+
+	MappedFile file(filename);
+	try {
+		glm::uvec2 image_size = qoi_size(file.data, file.size);
+		data->resize(size_t(image_size.x) * image_size.y);
+		load_qoi(file.data, file.size, size, data->data(), data->size(), origin);
+	} catch (std::runtime_error &e) {
+		throw std::runtime_error("Failed to read QOI image from '" + filename + "': " + e.what());
+	}
+}
+
+void save_qoi(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin) {
+	std::vector< uint8_t > qoi;
+	encode_qoi(size, data, origin, &qoi);
+	std::ofstream file(filename.c_str(), std::ios::binary);
+	if (!file.write(reinterpret_cast< char const * >(qoi.data()), qoi.size())) {
+		throw std::runtime_error("Failed to write QOI to '" + filename + "'.");
+	}
+}
+
+glm::uvec2 qoi_size(void const *qoi_, size_t qoi_bytes) {
+	uint8_t const *qoi = reinterpret_cast< uint8_t const * >(qoi_);
+	if (qoi_bytes < HeaderSize + sizeof(Padding) || std::memcmp(qoi, "qoif", 4) != 0) {
+		throw std::runtime_error("Not a QOI image.");
+	}
+	return glm::uvec2(read_u32(qoi + 4), read_u32(qoi + 8));
+}
+
+void load_qoi(void const *qoi_, size_t qoi_bytes, glm::uvec2 *size_, glm::u8vec4 *pixels, size_t capacity, OriginLocation origin) {
+	assert(size_);
+	*size_ = glm::uvec2(0);
+
+	glm::uvec2 size = qoi_size(qoi_, qoi_bytes);
+	if (size_t(size.x) * size.y > capacity) {
+		throw std::runtime_error("Image is " + std::to_string(size.x) + "x" + std::to_string(size.y) + ", which doesn't fit in " + std::to_string(capacity) + " pixels.");
+	}
+
+	uint8_t const *at = reinterpret_cast< uint8_t const * >(qoi_) + HeaderSize;
+	//ops are at most 5 bytes, and the stream ends with 8 bytes of padding, so reading an op that starts before this is safe:
+	uint8_t const *ops_end = reinterpret_cast< uint8_t const * >(qoi_) + qoi_bytes - sizeof(Padding);
+
+	glm::u8vec4 index[64];
+	for (auto &i : index) i = glm::u8vec4(0);
+	glm::u8vec4 px(0, 0, 0, 255);
+	uint32_t run = 0;
+
+	for (uint32_t r = 0; r < size.y; ++r) {
+		//(the origin flip is just a choice of destination row)
+		glm::u8vec4 *row = pixels + size_t(origin == LowerLeftOrigin ? size.y - 1 - r : r) * size.x;
+		for (uint32_t x = 0; x < size.x; ++x) {
+			if (run > 0) {
+				run -= 1;
+			} else {
+				if (at >= ops_end) throw std::runtime_error("Unexpected end of data.");
+				uint8_t op = *(at++);
+				if (op == OpRGB) {
+					px.r = at[0];
+					px.g = at[1];
+					px.b = at[2];
+					at += 3;
+				} else if (op == OpRGBA) {
+					px.r = at[0];
+					px.g = at[1];
+					px.b = at[2];
+					px.a = at[3];
+					at += 4;
+				} else if ((op & Mask2) == OpIndex) {
+					px = index[op];
+				} else if ((op & Mask2) == OpDiff) {
+					px.r += ((op >> 4) & 0x03) - 2;
+					px.g += ((op >> 2) & 0x03) - 2;
+					px.b += ( op       & 0x03) - 2;
+				} else if ((op & Mask2) == OpLuma) {
+					uint8_t b2 = *(at++);
+					int vg = (op & 0x3f) - 32;
+					px.r += vg - 8 + ((b2 >> 4) & 0x0f);
+					px.g += vg;
+					px.b += vg - 8 + ( b2       & 0x0f);
+				} else { //OpRun
+					run = (op & 0x3f);
+				}
+				index[index_of(px)] = px;
+			}
+			row[x] = px;
+		}
+	}
+
+	*size_ = size;
+}
+
+void encode_qoi(glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin, std::vector< uint8_t > *qoi) {
+	assert(qoi);
+	assert(data || size.x * size.y == 0);
+
+	//worst case is every pixel as OpRGBA:
+	qoi->resize(HeaderSize + size_t(size.x) * size.y * 5 + sizeof(Padding));
+	uint8_t *out = qoi->data();
+
+	std::memcpy(out, "qoif", 4);
+	out = write_u32(out + 4, size.x);
+	out = write_u32(out, size.y);
+	*(out++) = 4; //channels: RGBA
+	*(out++) = 0; //colorspace: sRGB with linear alpha
+
+	glm::u8vec4 index[64];
+	for (auto &i : index) i = glm::u8vec4(0);
+	glm::u8vec4 prev(0, 0, 0, 255);
+	uint32_t run = 0;
+
+	for (uint32_t r = 0; r < size.y; ++r) {
+		glm::u8vec4 const *row = data + size_t(origin == LowerLeftOrigin ? size.y - 1 - r : r) * size.x;
+		for (uint32_t x = 0; x < size.x; ++x) {
+			glm::u8vec4 px = row[x];
+			if (px == prev) {
+				run += 1;
+				if (run == 62) {
+					*(out++) = OpRun | uint8_t(run - 1);
+					run = 0;
+				}
+				continue;
+			}
+			if (run > 0) {
+				*(out++) = OpRun | uint8_t(run - 1);
+				run = 0;
+			}
+
+			uint32_t i = index_of(px);
+			if (index[i] == px) {
+				*(out++) = OpIndex | uint8_t(i);
+			} else {
+				index[i] = px;
+				if (px.a == prev.a) {
+					int8_t vr = int8_t(px.r - prev.r);
+					int8_t vg = int8_t(px.g - prev.g);
+					int8_t vb = int8_t(px.b - prev.b);
+					int8_t vg_r = int8_t(vr - vg);
+					int8_t vg_b = int8_t(vb - vg);
+					if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+						*(out++) = OpDiff | uint8_t((vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+					} else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+						*(out++) = OpLuma | uint8_t(vg + 32);
+						*(out++) = uint8_t((vg_r + 8) << 4 | (vg_b + 8));
+					} else {
+						*(out++) = OpRGB;
+						*(out++) = px.r;
+						*(out++) = px.g;
+						*(out++) = px.b;
+					}
+				} else {
+					*(out++) = OpRGBA;
+					*(out++) = px.r;
+					*(out++) = px.g;
+					*(out++) = px.b;
+					*(out++) = px.a;
+				}
+			}
+			prev = px;
+		}
+	}
+	if (run > 0) {
+		*(out++) = OpRun | uint8_t(run - 1);
+	}
+
+	std::memcpy(out, Padding, sizeof(Padding));
+	out += sizeof(Padding);
+	qoi->resize(out - qoi->data());
+}
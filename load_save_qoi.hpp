@@ -0,0 +1,30 @@
+#pragma once
+
+#include "load_save_png.hpp" //for OriginLocation
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * Load and save QOI ("Quite OK Image", https://qoiformat.org) files.
+ *
+ * QOI is lossless like PNG, but encodes in a single pass with no entropy
+ *  coder, so it is many times faster to write and read (and files are
+ *  usually somewhat larger). Good for frame captures and baked sprites.
+ *
+ * Images are always RGBA (channels = 4) here; any QOI file can be loaded.
+ */
+
+//NOTE: these throw on error
+void load_qoi(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin);
+void save_qoi(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin);
+
+//in memory, like the in-memory load_png: qoi_size reads the size from the header,
+// load_qoi decodes into 'pixels' (which must have room for 'capacity' pixels),
+// and encode_qoi replaces the contents of *qoi with the encoded image.
+glm::uvec2 qoi_size(void const *qoi, size_t qoi_bytes);
+void load_qoi(void const *qoi, size_t qoi_bytes, glm::uvec2 *size, glm::u8vec4 *pixels, size_t capacity, OriginLocation origin);
+void encode_qoi(glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin, std::vector< uint8_t > *qoi);
@@ -3,12 +3,29 @@
 
 //The 'PongMode' mode plays the game:
 #include "PongMode.hpp"
+//...and 'MultiBallMode' plays it with a court full of balls (pong --multiball [balls]):
+#include "MultiBallMode.hpp"
 
 //GL.hpp will include a non-namespace-polluting set of opengl prototypes:
 #include "GL.hpp"
+//...plus any optional extensions the driver offers:
+#include "gl_extensions.hpp"
+//...and redundant-state filtering:
+#include "GLState.hpp"
+
+//for measuring time spent on the GPU:
+#include "GPUTimer.hpp"
+//...and on the CPU:
+#include "Profiler.hpp"
 
 //for screenshots:
-#include "load_save_png.hpp"
+#include "FrameCapture.hpp"
+
+//for loading textures in the background:
+#include "AssetLoader.hpp"
+
+//for caching compiled shader programs between runs:
+#include "gl_compile_program.hpp"
 
 //Includes for libSDL:
 #include <SDL.h>
@@ -16,9 +33,11 @@
 //...and for c++ standard library functions:
 #include <chrono>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include <string>
 
 int main(int argc, char **argv) {
 #ifdef _WIN32
@@ -26,12 +45,75 @@ int main(int argc, char **argv) {
 	try {
 #endif
 
+	//------------  command line ------------
+
+	//'--multiball [balls]' starts in MultiBallMode instead of PongMode:
+	uint32_t multiball = 0;
+	//'--record file' saves the match's input to a replay file; '--replay file' plays one back:
+	std::string record_filename;
+	std::string replay_filename;
+	//'--profile file' saves profiler zones to 'file' on exit (F2 saves them at any time):
+	std::string profile_filename;
+	bool profile_on_exit = false;
+	//'--capture prefix' records every frame to prefix-NNNNNN.png (F3 starts/stops recording at any time):
+	std::string capture_prefix;
+	//'--capture-qoi' records frames as .qoi instead, which is much cheaper to encode:
+	bool capture_qoi = false;
+	//'--no-program-cache' always compiles shader programs from source (rather than loading them from the last run):
+	bool program_cache = true;
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--multiball") {
+			multiball = 2000;
+			if (argi + 1 < argc && argv[argi+1][0] != '-') {
+				multiball = uint32_t(std::stoul(argv[argi+1]));
+				argi += 1;
+			}
+		} else if (arg == "--record" && argi + 1 < argc) {
+			record_filename = argv[argi+1];
+			argi += 1;
+		} else if (arg == "--replay" && argi + 1 < argc) {
+			replay_filename = argv[argi+1];
+			argi += 1;
+		} else if (arg == "--profile" && argi + 1 < argc) {
+			profile_filename = argv[argi+1];
+			profile_on_exit = true;
+			argi += 1;
+		} else if (arg == "--capture" && argi + 1 < argc) {
+			capture_prefix = argv[argi+1];
+			argi += 1;
+		} else if (arg == "--capture-qoi") {
+			capture_qoi = true;
+		} else if (arg == "--no-program-cache") {
+			program_cache = false;
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--multiball [balls]] [--record replay-file | --replay replay-file] [--profile trace.json] [--capture frame-prefix] [--capture-qoi] [--no-program-cache]" << std::endl;
+			return 1;
+		}
+	}
+	if (multiball && (record_filename != "" || replay_filename != "")) {
+		std::cerr << "Replays are only supported for regular (not --multiball) games." << std::endl;
+		return 1;
+	}
+	if (record_filename != "" && replay_filename != "") {
+		std::cerr << "Can't both --record and --replay." << std::endl;
+		return 1;
+	}
+
+	if (profile_filename == "") profile_filename = "profile.json";
+
+	//load replay before opening a window so a bad file fails fast:
+	Replay replay;
+	if (replay_filename != "") {
+		load_replay(replay_filename, &replay);
+	}
+
 	//------------  initialization ------------
 
 	//Initialize SDL library:
 	SDL_Init(SDL_INIT_VIDEO);
 
-	//Ask for an OpenGL context version 3.3, core profile, enable debug:
+	//Ask for an OpenGL context version 3.3, core profile, enable debug (or, in release builds, disable error checking):
 	SDL_GL_ResetAttributes();
 	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
 	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
@@ -41,7 +123,14 @@ int main(int argc, char **argv) {
 	SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
 	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	#ifdef NDEBUG
+	//(release builds never check for errors, so let the driver skip them too, where supported)
+	#if SDL_VERSION_ATLEAST(2, 0, 6)
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_NO_ERROR, 1);
+	#endif
+	#else
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+	#endif
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
 
@@ -74,6 +163,18 @@ int main(int argc, char **argv) {
 
 	//On windows, load OpenGL entrypoints: (does nothing on other platforms)
 	init_GL();
+	//...and look up the optional extensions we can take advantage of:
+	init_GL_extensions();
+
+	//keep linked shader programs in the per-user data directory, so later runs can skip compiling them:
+	if (program_cache) {
+		if (char *pref_path = SDL_GetPrefPath("gp20", "pong")) {
+			gl_program_cache.directory = pref_path;
+			SDL_free(pref_path);
+		} else {
+			std::cerr << "NOTE: no place to cache shader programs (" << SDL_GetError() << ")." << std::endl;
+		}
+	}
 
 	//Set VSYNC + Late Swap (prevents crazy FPS):
 	if (SDL_GL_SetSwapInterval(-1) != 0) {
@@ -87,7 +188,21 @@ int main(int argc, char **argv) {
 	//SDL_ShowCursor(SDL_DISABLE);
 
 	//------------ create game mode + make current --------------
-	Mode::set_current(std::make_shared< PongMode >());
+	if (multiball) {
+		Mode::set_current(std::make_shared< MultiBallMode >(multiball));
+	} else {
+		auto pong = std::make_shared< PongMode >();
+		if (record_filename != "") {
+			//any seed will do; it is saved in the replay:
+			uint64_t seed = uint64_t(std::chrono::system_clock::now().time_since_epoch().count());
+			pong->start_recording(record_filename, seed);
+			std::cout << "Recording to '" << record_filename << "' (seed " << seed << ")." << std::endl;
+		} else if (replay_filename != "") {
+			pong->start_playback(replay);
+			std::cout << "Playing back '" << replay_filename << "' (" << replay.steps.size() << " steps)." << std::endl;
+		}
+		Mode::set_current(pong);
+	}
 
 	//------------ main loop ------------
 
@@ -106,12 +221,30 @@ int main(int argc, char **argv) {
 	};
 	on_resize();
 
+	//CPU time (smoothed) spent in update and draw, shown in the window title along with gpu_timer's results:
+	double update_ms = 0.0;
+	double draw_ms = 0.0;
+	auto title_time = std::chrono::high_resolution_clock::now();
+	auto smooth = [](double *average, std::chrono::high_resolution_clock::time_point before) {
+		double ms = std::chrono::duration< double, std::milli >(std::chrono::high_resolution_clock::now() - before).count();
+		*average += 0.1 * (ms - *average);
+	};
+
+	profile_thread_name("main");
+
+	//saves screenshots and recordings without stalling the loop:
+	FrameCapture capture;
+	if (capture_qoi) capture.record_extension = ".qoi";
+	if (capture_prefix != "") capture.start_recording(capture_prefix);
+
 	//This will loop until the current mode is set to null:
 	while (Mode::current) {
 		//every pass through the game loop creates one frame of output
 		//  by performing three steps:
+		PROFILE_ZONE("frame");
 
 		{ //(1) process any events that are pending
+			PROFILE_ZONE("events");
 			static SDL_Event evt;
 			while (SDL_PollEvent(&evt) == 1) {
 				//handle resizing:
@@ -126,49 +259,107 @@ int main(int argc, char **argv) {
 					break;
 				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_PRINTSCREEN) {
 					// --- screenshot key ---
+					//(the next frame is read back and saved in the background)
 					std::string filename = "screenshot.png";
 					std::cout << "Saving screenshot to '" << filename << "'." << std::endl;
-					glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-					glReadBuffer(GL_FRONT);
-					int w,h;
-					SDL_GL_GetDrawableSize(window, &w, &h);
-					std::vector< glm::u8vec4 > data(w*h);
-					glReadPixels(0,0,w,h, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
-					for (auto &px : data) {
-						px.a = 0xff;
+					capture.request(filename);
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F3) {
+					// --- recording key ---
+					if (capture.recording) capture.stop_recording();
+					else capture.start_recording(capture_prefix != "" ? capture_prefix : "capture");
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F2) {
+					// --- profile dump key ---
+					std::cout << "Saving profile to '" << profile_filename << "'." << std::endl;
+					try {
+						profile_dump(profile_filename);
+					} catch (std::exception &e) {
+						std::cerr << "WARNING: failed to save profile: " << e.what() << std::endl;
 					}
-					save_png(filename, glm::uvec2(w,h), data.data(), LowerLeftOrigin);
 				}
 			}
 			if (!Mode::current) break;
 		}
 
-		{ //(2) call the current mode's "update" function to deal with elapsed time:
+		//real time that has passed but has not yet been simulated:
+		static double accumulator = 0.0;
+
+		{ //(2) call the current mode's "update" function once per fixed Tick of elapsed time:
+			PROFILE_ZONE("update");
 			auto current_time = std::chrono::high_resolution_clock::now();
 			static auto previous_time = current_time;
-			float elapsed = std::chrono::duration< float >(current_time - previous_time).count();
+			accumulator += std::chrono::duration< double >(current_time - previous_time).count();
 			previous_time = current_time;
 
-			//if frames are taking a very long time to process,
-			//lag to avoid spiral of death:
-			elapsed = std::min(0.1f, elapsed);
-
-			Mode::current->update(elapsed);
+			//NOTE: no clamp on the accumulator -- every real second is simulated as exactly 1/Tick updates,
+			// so a slow frame is caught up on the next frame rather than silently slowing game time.
+			while (accumulator >= Mode::Tick) {
+				Mode::current->update(Mode::Tick);
+				accumulator -= Mode::Tick;
+				if (!Mode::current) break;
+			}
 			if (!Mode::current) break;
+			smooth(&update_ms, current_time);
 		}
 
 		{ //(3) call the current mode's "draw" function to produce output:
-		
-			Mode::current->draw(drawable_size);
+			PROFILE_ZONE("draw");
+			//how far (as a fraction of a Tick) real time is past the last update:
+			float alpha = float(accumulator / Mode::Tick);
+
+			//upload textures that finished loading in the background (for at most a couple of milliseconds):
+			asset_loader.update(2.0f);
+
+			auto before = std::chrono::high_resolution_clock::now();
+			gpu_timer.begin_frame();
+			Mode::current->draw(drawable_size, alpha);
+			gpu_timer.end_frame();
+			smooth(&draw_ms, before);
+
+			//read back the frame if it is being captured:
+			capture.end_frame(drawable_size);
 		}
 
-		//Wait until the recently-drawn frame is shown before doing it all again:
-		SDL_GL_SwapWindow(window);
+		//show timings (a couple times a second, since setting the title isn't free):
+		if (std::chrono::high_resolution_clock::now() - title_time > std::chrono::milliseconds(500)) {
+			title_time = std::chrono::high_resolution_clock::now();
+			std::ostringstream title;
+			title.setf(std::ios::fixed);
+			title.precision(2);
+			title << "gp20 pong | cpu: update " << update_ms << " draw " << draw_ms << " ms | gpu:";
+			for (auto const &result : gpu_timer.results) {
+				title << " " << result.name << " " << result.ms;
+			}
+			title << " ms";
+			SDL_SetWindowTitle(window, title.str().c_str());
+		}
+
+		{ //Wait until the recently-drawn frame is shown before doing it all again:
+			PROFILE_ZONE("swap");
+			SDL_GL_SwapWindow(window);
+		}
 	}
 
 
 	//------------  teardown ------------
 
+	gpu_timer.release();
+	capture.finish();
+	asset_loader.release();
+
+	if (profile_on_exit) {
+		std::cout << "Saving profile to '" << profile_filename << "'." << std::endl;
+		try {
+			profile_dump(profile_filename);
+		} catch (std::exception &e) {
+			std::cerr << "WARNING: failed to save profile: " << e.what() << std::endl;
+		}
+	}
+
+	std::cout << "GL state changes: " << gl_state.calls << " made, " << gl_state.avoided << " skipped as redundant." << std::endl;
+	std::cout << "Shader programs: " << gl_program_cache.hits << " loaded from cache, " << gl_program_cache.compiled << " compiled";
+	if (gl_program_cache.rejected) std::cout << " (" << gl_program_cache.rejected << " cached programs rejected by the driver)";
+	std::cout << "; " << gl_program_cache.ms << " ms total." << std::endl;
+
 	SDL_GL_DeleteContext(context);
 	context = 0;
 
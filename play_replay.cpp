@@ -0,0 +1,67 @@
+//pong-replay re-runs a recorded match (see Replay.hpp) as fast as the CPU allows.
+// usage: pong-replay replay-file [repeats]
+//Since a replay is the match's complete input, every run does exactly the same
+// work; the final state is checked against the checksum saved with the recording.
+//(Record a replay with 'pong --record file'.)
+
+#include "Replay.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+int main(int argc, char **argv) {
+	std::string filename;
+	uint32_t repeats = 100;
+
+	Replay replay;
+	try {
+		if (argc < 2) throw std::invalid_argument("no replay file given");
+		filename = argv[1];
+		if (argc > 2) repeats = uint32_t(std::stoul(argv[2]));
+		if (argc > 3) throw std::invalid_argument("too many arguments");
+		load_replay(filename, &replay);
+	} catch (std::exception const &e) {
+		std::cerr << "Usage:\n\t" << argv[0] << " replay-file [repeats]\n(" << e.what() << ")" << std::endl;
+		return 1;
+	}
+
+	uint32_t steps = uint32_t(replay.steps.size());
+	double recorded_seconds = 0.0;
+	for (auto const &step : replay.steps) {
+		recorded_seconds += step.elapsed;
+	}
+	std::cout << "'" << filename << "': " << steps << " steps (" << recorded_seconds << "s of play), seed " << replay.seed << "." << std::endl;
+
+	PongGame game;
+	bool all_match = true;
+	auto before = std::chrono::high_resolution_clock::now();
+	for (uint32_t repeat = 0; repeat < repeats; ++repeat) {
+		replay.start(&game);
+		for (uint32_t step = 0; step < steps; ++step) {
+			replay.play(step, &game);
+		}
+		if (replay.final_checksum != 0 && Replay::checksum(game) != replay.final_checksum) {
+			all_match = false;
+		}
+	}
+	auto after = std::chrono::high_resolution_clock::now();
+	double elapsed = std::chrono::duration< double >(after - before).count();
+
+	std::cout << "Replayed " << repeats << " times in " << elapsed << "s:" << std::endl;
+	std::cout << "  " << (double(steps) * repeats / elapsed) << " steps/second; "
+	          << (recorded_seconds * repeats / elapsed) << "x real time." << std::endl;
+	std::cout << "  final score " << game.left_score << " - " << game.right_score
+	          << "; checksum " << std::hex << Replay::checksum(game) << std::dec << "." << std::endl;
+
+	if (replay.final_checksum == 0) {
+		std::cout << "  (no checksum was recorded to compare against)" << std::endl;
+	} else if (!all_match) {
+		std::cout << "  ERROR: final state differs from the recording (expected checksum " << std::hex << replay.final_checksum << std::dec << ")." << std::endl;
+		return 1;
+	} else {
+		std::cout << "  (final state matches the recording)" << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,100 @@
+//texture-bake bakes an image into a texture that loads without decoding or mipmap generation (see bake_texture.hpp).
+// usage: texture-bake [--rgba|--bc1|--bc3] [--no-mips] input.(png|qoi) output.tex
+//The default format is BC1 for fully opaque images and BC3 otherwise.
+//Prints the sizes involved and the error (PSNR) that compression introduced in the full-size level.
+
+#include "bake_texture.hpp"
+#include "file_extension.hpp"
+#include "load_save_png.hpp"
+#include "load_save_qoi.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	std::string format_name = "auto";
+	bool mipmaps = true;
+	std::string input, output;
+	try {
+		for (int argi = 1; argi < argc; ++argi) {
+			std::string arg = argv[argi];
+			if (arg == "--rgba" || arg == "--bc1" || arg == "--bc3") format_name = arg.substr(2);
+			else if (arg == "--no-mips") mipmaps = false;
+			else if (arg[0] == '-') throw std::invalid_argument("unknown option '" + arg + "'");
+			else if (input == "") input = arg;
+			else if (output == "") output = arg;
+			else throw std::invalid_argument("too many arguments");
+		}
+		if (output == "") throw std::invalid_argument("expecting input and output filenames");
+	} catch (std::exception const &e) {
+		std::cerr << "Usage:\n\t" << argv[0] << " [--rgba|--bc1|--bc3] [--no-mips] input.(png|qoi) output.tex\n(" << e.what() << ")" << std::endl;
+		return 1;
+	}
+
+	try {
+		//load bottom-to-top, as OpenGL (and so the baked texture) expects:
+		glm::uvec2 size;
+		std::vector< glm::u8vec4 > data;
+		if (has_extension(input, ".qoi")) load_qoi(input, &size, &data, LowerLeftOrigin);
+		else load_png(input, &size, &data, LowerLeftOrigin);
+
+		BakedTextureFormat format = BakedRGBA8;
+		if (format_name == "bc1") format = BakedBC1;
+		else if (format_name == "bc3") format = BakedBC3;
+		else if (format_name == "auto") {
+			bool opaque = true;
+			for (auto const &px : data) {
+				if (px.a != 0xff) {
+					opaque = false;
+					break;
+				}
+			}
+			format = (opaque ? BakedBC1 : BakedBC3);
+		}
+
+		auto before = std::chrono::high_resolution_clock::now();
+		std::vector< uint8_t > baked;
+		bake_texture(size, data.data(), format, mipmaps, &baked);
+		double ms = std::chrono::duration< double, std::milli >(std::chrono::high_resolution_clock::now() - before).count();
+
+		std::ofstream file(output, std::ios::binary);
+		if (!file.write(reinterpret_cast< char const * >(baked.data()), baked.size())) {
+			throw std::runtime_error("failed to write '" + output + "'");
+		}
+
+		BakedTexture texture;
+		parse_baked_texture(baked.data(), baked.size(), &texture);
+		size_t rgba_bytes = 0;
+		for (auto const &level : texture.levels) {
+			rgba_bytes += size_t(level.size.x) * level.size.y * 4;
+		}
+		std::cout << input << " -> " << output << ": " << size.x << "x" << size.y << ", "
+			<< (format == BakedBC1 ? "BC1" : format == BakedBC3 ? "BC3" : "RGBA8") << ", " << texture.levels.size() << " level(s), "
+			<< baked.size() << " bytes (vs. " << rgba_bytes << " as RGBA8), baked in " << ms << " ms" << std::endl;
+
+		if (format != BakedRGBA8) {
+			std::vector< glm::u8vec4 > decompressed(data.size());
+			decompress_blocks(format, size, texture.levels[0].data, decompressed.data());
+			double squared_error = 0.0;
+			uint32_t channels = (format == BakedBC1 ? 3 : 4);
+			for (size_t i = 0; i < data.size(); ++i) {
+				for (uint32_t c = 0; c < channels; ++c) {
+					double d = double(data[i][c]) - double(decompressed[i][c]);
+					squared_error += d * d;
+				}
+			}
+			double mse = squared_error / (double(data.size()) * channels);
+			std::cout << "  PSNR: " << (mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : INFINITY) << " dB" << std::endl;
+		}
+	} catch (std::exception const &e) {
+		std::cerr << "Failed to bake '" << input << "': " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}